@@ -28,7 +28,11 @@ public:
 	};
 
 public:
-	aabb_tree() : pool_( page_provider_, "aabbt" ) { root_ = NULL; }
+	aabb_tree( page_arena& arena = page_arena::instance() )
+		: page_provider_( arena ), pool_( page_provider_, "aabbt" )
+	{
+		root_ = NULL;
+	}
 	~aabb_tree() { /* destroy_node( root_ ); */ }
 
 	void clear()
@@ -37,6 +41,8 @@ public:
 		pool_.clear();
 	}
 
+	bool empty() { return root_ == NULL; }
+
 	void insert(
 		const vector_type& min,
 		const vector_type& max,
@@ -59,10 +65,61 @@ public:
 		const vector_type& max,
 		const CallBack& c )
 	{
+		if( !root_ ) { return; }
 		detect_aux( root_, min, max, c );
 	}
 
+	// ėp̑
+	//	 v.enter( min, max, s, t )falseԂm[h̉ɂ͍~ȂB
+	//	 s͐em[hł̏ԁAt͎qm[hɓn
+	//	 (Visitor::state_type, raỹ}XNȂ)
+	//	 c[Ȃ̂ŁAXbh瓯ɌĂł悢
+	template < class Visitor >
+	void traverse( Visitor& v, typename Visitor::state_type s ) const
+	{
+		if( !root_ ) { return; }
+		traverse_aux( root_, v, s );
+	}
+
+	// tAABBg( user, min, max )Ŏ蒼Ae蒼
+	//	 ؂̌`͕ςȂ
+	template < class Getter >
+	void refit( const Getter& g )
+	{
+		if( !root_ ) { return; }
+		refit_aux( root_, g );
+	}
+
 private:
+	template < class Getter >
+	void refit_aux( aabb_node* p, const Getter& g )
+	{
+		if( !p->car /* && !p->cdr */ ) {
+			g( p->user, p->min, p->max );
+			return;
+		}
+		refit_aux( p->car, g );
+		refit_aux( p->cdr, g );
+		unify_aabb( p->min, p->max, p->car, p->cdr );
+	}
+
+	template < class Visitor >
+	static void traverse_aux(
+		const aabb_node* p,
+		Visitor& v,
+		typename Visitor::state_type s )
+	{
+		typename Visitor::state_type t;
+		if( !v.enter( p->min, p->max, s, t ) ) { return; }
+
+		if( !p->car /* && !p->cdr */ ) {
+			v.leaf( p->user, t );
+		} else {
+			traverse_aux( p->car, v, t );
+			traverse_aux( p->cdr, v, t );
+		}
+	}
+
 	aabb_node* create_node()
 	{
 		return (aabb_node*)pool_.allocate();
@@ -214,8 +271,8 @@ private:
 	}
 
 private:
-	default_page_provider page_provider_;
-	fixed_pool< sizeof( aabb_node ), default_page_provider > pool_;
+	arena_page_provider page_provider_;
+	fixed_pool< sizeof( aabb_node ), arena_page_provider > pool_;
 
 	aabb_node* root_;
 
@@ -0,0 +1,46 @@
+/*!
+  @file     allocation_counter.hpp
+  @brief    <Tv>
+
+  O[ooperator new̌Ăяo񐔂𐔂(fobOp)
+  PARTIX_DEFINE_ALLOCATION_COUNTER`1̖|Pʂinclude
+  operator new/deleteuĐ悤ɂȂB
+  `ȂΏ0ԂB
+*/
+#ifndef ALLOCATION_COUNTER_HPP
+#define ALLOCATION_COUNTER_HPP
+
+#include <cstddef>
+
+namespace partix {
+
+inline size_t& allocation_counter()
+{
+    static size_t counter = 0;
+    return counter;
+}
+
+} // namespace partix
+
+#ifdef PARTIX_DEFINE_ALLOCATION_COUNTER
+
+#include <cstdlib>
+#include <new>
+
+// new[]/delete[]͊łĂ
+void* operator new( size_t size )
+{
+    partix::allocation_counter()++;
+    void* p = malloc( size ? size : 1 );
+    if( !p ) { throw std::bad_alloc(); }
+    return p;
+}
+
+void operator delete( void* p ) noexcept
+{
+    free( p );
+}
+
+#endif // PARTIX_DEFINE_ALLOCATION_COUNTER
+
+#endif // ALLOCATION_COUNTER_HPP
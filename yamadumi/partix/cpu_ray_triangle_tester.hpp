@@ -8,6 +8,8 @@
 #ifndef RAYTRIANGLETESTER_HPP
 #define RAYTRIANGLETESTER_HPP
 
+#include <limits>
+
 template < class VectorTraits, int MAX_RAY_COUNT, int MAX_TRIANGLE_COUNT >
 class CpuRayTriangleTester {
 public:
@@ -218,4 +220,207 @@ private:
 
 };
 
+// RayTrianglePacketTester
+//	 Moller-TrumboreOp`1raypacketA
+//	 ܂ray1{ΎOp`packetł܂Ƃ߂čsB
+//	 [Ƃ̔zɕׂĕȂĂ̂
+//	 [v̓RpCSIMDłB
+//	 ƌʂmath::test_segment_triangleƓ
+template < class VectorTraits, int PACKET_SIZE >
+class RayTrianglePacketTester {
+public:
+	typedef typename VectorTraits::real_type		real_type;
+	typedef typename VectorTraits::vector_type		vector_type;
+
+	enum { packet_size = PACKET_SIZE };
+
+	// n_ƌ
+	struct RayPacket {
+		real_type		ox[PACKET_SIZE];
+		real_type		oy[PACKET_SIZE];
+		real_type		oz[PACKET_SIZE];
+		real_type		dx[PACKET_SIZE];
+		real_type		dy[PACKET_SIZE];
+		real_type		dz[PACKET_SIZE];
+		int				count;
+	};
+
+	// _02
+	struct TrianglePacket {
+		real_type		v0x[PACKET_SIZE];
+		real_type		v0y[PACKET_SIZE];
+		real_type		v0z[PACKET_SIZE];
+		real_type		e1x[PACKET_SIZE];
+		real_type		e1y[PACKET_SIZE];
+		real_type		e1z[PACKET_SIZE];
+		real_type		e2x[PACKET_SIZE];
+		real_type		e2y[PACKET_SIZE];
+		real_type		e2z[PACKET_SIZE];
+		int				count;
+	};
+
+	typedef RayPacket		ray_packet_type;
+	typedef TrianglePacket	triangle_packet_type;
+
+public:
+	// 󂫃[0Ŗ߂Ă(NaNȂǂŒxȂȂ悤)
+	static void clear( RayPacket& p )
+	{
+		for( int i = 0 ; i < PACKET_SIZE ; i++ ) {
+			p.ox[i] = p.oy[i] = p.oz[i] = 0;
+			p.dx[i] = p.dy[i] = p.dz[i] = 0;
+		}
+		p.count = 0;
+	}
+
+	static void clear( TrianglePacket& p )
+	{
+		for( int i = 0 ; i < PACKET_SIZE ; i++ ) {
+			p.v0x[i] = p.v0y[i] = p.v0z[i] = 0;
+			p.e1x[i] = p.e1y[i] = p.e1z[i] = 0;
+			p.e2x[i] = p.e2y[i] = p.e2z[i] = 0;
+		}
+		p.count = 0;
+	}
+
+	static int add_ray(
+		RayPacket& p, const vector_type& r0, const vector_type& r1 )
+	{
+		int i = p.count++;
+		p.ox[i] = VectorTraits::x( r0 );
+		p.oy[i] = VectorTraits::y( r0 );
+		p.oz[i] = VectorTraits::z( r0 );
+		p.dx[i] = VectorTraits::x( r1 ) - VectorTraits::x( r0 );
+		p.dy[i] = VectorTraits::y( r1 ) - VectorTraits::y( r0 );
+		p.dz[i] = VectorTraits::z( r1 ) - VectorTraits::z( r0 );
+		return i;
+	}
+
+	static int add_triangle(
+		TrianglePacket& p,
+		const vector_type& v0,
+		const vector_type& v1,
+		const vector_type& v2 )
+	{
+		int i = p.count++;
+		p.v0x[i] = VectorTraits::x( v0 );
+		p.v0y[i] = VectorTraits::y( v0 );
+		p.v0z[i] = VectorTraits::z( v0 );
+		p.e1x[i] = VectorTraits::x( v1 ) - VectorTraits::x( v0 );
+		p.e1y[i] = VectorTraits::y( v1 ) - VectorTraits::y( v0 );
+		p.e1z[i] = VectorTraits::z( v1 ) - VectorTraits::z( v0 );
+		p.e2x[i] = VectorTraits::x( v2 ) - VectorTraits::x( v0 );
+		p.e2y[i] = VectorTraits::y( v2 ) - VectorTraits::y( v0 );
+		p.e2z[i] = VectorTraits::z( v2 ) - VectorTraits::z( v0 );
+		return i;
+	}
+
+	// Op`1raypacket
+	//	 [̃rbgԂBu, v, t͓[L
+	static unsigned int test_rays(
+		const RayPacket&	p,
+		const vector_type&	v0,
+		const vector_type&	v1,
+		const vector_type&	v2,
+		real_type*			u,
+		real_type*			v,
+		real_type*			t )
+	{
+		real_type v0x = VectorTraits::x( v0 );
+		real_type v0y = VectorTraits::y( v0 );
+		real_type v0z = VectorTraits::z( v0 );
+		real_type e1x = VectorTraits::x( v1 ) - v0x;
+		real_type e1y = VectorTraits::y( v1 ) - v0y;
+		real_type e1z = VectorTraits::z( v1 ) - v0z;
+		real_type e2x = VectorTraits::x( v2 ) - v0x;
+		real_type e2y = VectorTraits::y( v2 ) - v0y;
+		real_type e2z = VectorTraits::z( v2 ) - v0z;
+
+		unsigned int mask = 0;
+		for( int i = 0 ; i < PACKET_SIZE ; i++ ) {
+			bool hit = lane(
+				p.ox[i], p.oy[i], p.oz[i], p.dx[i], p.dy[i], p.dz[i],
+				v0x, v0y, v0z, e1x, e1y, e1z, e2x, e2y, e2z,
+				u[i], v[i], t[i] );
+			mask |= ( hit ? 1u : 0u ) << i;
+		}
+		return mask & ( ( 1u << p.count ) - 1 );
+	}
+
+	// ray1{ΎOp`packet
+	static unsigned int test_triangles(
+		const TrianglePacket&	p,
+		const vector_type&		r0,
+		const vector_type&		r1,
+		real_type*				u,
+		real_type*				v,
+		real_type*				t )
+	{
+		real_type ox = VectorTraits::x( r0 );
+		real_type oy = VectorTraits::y( r0 );
+		real_type oz = VectorTraits::z( r0 );
+		real_type dx = VectorTraits::x( r1 ) - ox;
+		real_type dy = VectorTraits::y( r1 ) - oy;
+		real_type dz = VectorTraits::z( r1 ) - oz;
+
+		unsigned int mask = 0;
+		for( int i = 0 ; i < PACKET_SIZE ; i++ ) {
+			bool hit = lane(
+				ox, oy, oz, dx, dy, dz,
+				p.v0x[i], p.v0y[i], p.v0z[i],
+				p.e1x[i], p.e1y[i], p.e1z[i],
+				p.e2x[i], p.e2y[i], p.e2z[i],
+				u[i], v[i], t[i] );
+			mask |= ( hit ? 1u : 0u ) << i;
+		}
+		return mask & ( ( 1u << p.count ) - 1 );
+	}
+
+private:
+	static bool lane(
+		real_type ox, real_type oy, real_type oz,
+		real_type dx, real_type dy, real_type dz,
+		real_type v0x, real_type v0y, real_type v0z,
+		real_type e1x, real_type e1y, real_type e1z,
+		real_type e2x, real_type e2y, real_type e2z,
+		real_type& u, real_type& v, real_type& t )
+	{
+		// pvec = cross( dir, e2 )
+		real_type px = dy * e2z - dz * e2y;
+		real_type py = -dx * e2z + dz * e2x;
+		real_type pz = dx * e2y - dy * e2x;
+
+		real_type det = e1x * px + e1y * py + e1z * pz;
+
+		// tvec = r0 - v0
+		real_type tx = ox - v0x;
+		real_type ty = oy - v0y;
+		real_type tz = oz - v0z;
+
+		real_type uu = tx * px + ty * py + tz * pz;
+
+		// qvec = cross( tvec, e1 )
+		real_type qx = ty * e1z - tz * e1y;
+		real_type qy = -tx * e1z + tz * e1x;
+		real_type qz = tx * e1y - ty * e1x;
+
+		real_type vv = dx * qx + dy * qy + dz * qz;
+		real_type tt = e2x * qx + e2y * qy + e2z * qz;
+
+		// NaN̂ƂXJ[łƓɂȂ悤ɔےŏ
+		bool hit =
+			!( det < VectorTraits::epsilon() ) &
+			!( uu < 0 || uu > det ) &
+			!( vv < 0 || uu + vv > det ) &
+			!( tt < 0 || det < tt );
+
+		real_type idet = real_type( 1.0 ) / det;
+		u = uu * idet;
+		v = vv * idet;
+		t = tt * idet;
+		return hit;
+	}
+
+};
+
 #endif // RAYTRIANGLETESTER_HPP
@@ -3,6 +3,9 @@
 
 #include <new>
 #include <cassert>
+#include <cstddef>
+#include <vector>
+#include <algorithm>
 //#include "zw/dprintf.hpp"
 
 #pragma pack(push,1)
@@ -31,6 +34,10 @@ public:
 		unformated_beginning_ = NULL;
 		unformated_end_ = NULL;
 		formated_ = NULL;
+
+		page_count_ = 0;
+		page_high_water_ = 0;
+		allocation_count_ = 0;
 	}
 	~fixed_pool()
 	{
@@ -51,18 +58,37 @@ public:
 
 	void clear()
 	{
-		if( pages_head_ ) {
+		if( page_provider_.recycles_pages() ) {
+			// page_providerg񂷂̂Ŏ茳ɂ͎cȂ
+			page_header* p = pages_head_;
+			while( p ) {
+				page_header* q = p->next;
+				page_provider_.deallocate( p );
+				p = q;
+			}
+			page_count_ = 0;
+		} else if( pages_head_ ) {
 			append( unused_pages_, pages_head_ );
-			pages_head_ = NULL;
 		}
+		pages_head_ = NULL;
 
 		unformated_beginning_ = NULL;
 		unformated_end_ = NULL;
 		formated_ = NULL;
+		allocation_count_ = 0;
 	}
 
+	// v
+	//	 page_count:		ێĂy[W(gp܂)
+	//	 page_high_water:	page_count̍ől
+	//	 allocation_count:	Oclearȍ~allocate
+	size_t	page_count() const { return page_count_; }
+	size_t	page_high_water() const { return page_high_water_; }
+	size_t	allocation_count() const { return allocation_count_; }
+
 	void*	allocate()
 	{ 
+		allocation_count_++;
 		if( formated_ ) { 
 			// v[ĂꍇAԂ
 			void* x = ( void* )formated_;
@@ -110,6 +136,9 @@ protected:
 			// VɊ蓖Ă
 			new_page =
 				(page_header*)page_provider_.allocate( size );
+			if( page_high_water_ < ++page_count_ ) {
+				page_high_water_ = page_count_;
+			}
 
 #if 0
 			dprintf_real( "new_page: %s\n", name_.c_str() );
@@ -143,6 +172,10 @@ private:
 	char*			unformated_end_;
 	formated_tag*	formated_;
 
+	size_t			page_count_;
+	size_t			page_high_water_;
+	size_t			allocation_count_;
+
 #if 0
 	std::string		name_;
 #endif
@@ -218,6 +251,7 @@ public:
 	~default_page_provider() {}
 
 	size_t page_size() { return 32768; }
+	bool recycles_pages() { return false; }
 	void* allocate( size_t size )
 	{
 #if 0
@@ -240,6 +274,395 @@ public:
 	int counter_;
 };
 
+// page_arena
+//	 傫ȃ`N܂Ƃ߂ĊmۂA񂵂y[Wɐ؂蕪ĕoB
+//	 ԋpꂽy[W̓`Nɖ߂AtrimŊۂƋ󂢂`NB
+
+class page_arena {
+public:
+	enum {
+		default_page_size	= 32768,
+		default_chunk_size	= 1024 * 1024,
+		page_alignment		= 4096,
+	};
+
+	struct stats_type {
+		size_t	chunk_count;
+		size_t	page_count;				// mۍς݃y[W(󂫂܂)
+		size_t	pages_in_use;
+		size_t	page_high_water;		// pages_in_use̍ől
+		size_t	frame_allocations;		// begin_frameȍ~̕o
+		size_t	frame_deallocations;	// begin_frameȍ~̕ԋp
+	};
+
+public:
+	page_arena(
+		size_t page_size = default_page_size,
+		size_t chunk_size = default_chunk_size )
+		: page_size_( page_size ),
+		  pages_per_chunk_( chunk_size / page_size )
+	{
+		assert( page_size % page_alignment == 0 );
+		assert( 0 < pages_per_chunk_ );
+
+		free_pages_ = NULL;
+		pages_in_use_ = 0;
+		page_high_water_ = 0;
+		frame_allocations_ = 0;
+		frame_deallocations_ = 0;
+	}
+	~page_arena()
+	{
+		for( size_t i = 0 ; i < chunks_.size() ; i++ ) {
+			delete [] chunks_[i].raw;
+		}
+	}
+
+	// arenaw肵Ȃfixed_poolL
+	//	 bNȂ̂ŁAXbhĝɂ
+	//	 ꂼʂpage_arenan(WorldWorldƂɎ)
+	static page_arena& instance()
+	{
+		static page_arena arena;
+		return arena;
+	}
+
+	size_t page_size() { return page_size_; }
+
+	void* allocate( size_t size )
+	{
+		assert( size <= page_size_ );
+		if( !free_pages_ ) { add_chunk(); }
+
+		free_page* p = free_pages_;
+		free_pages_ = p->next;
+		find_chunk( p ).used++;
+
+		if( page_high_water_ < ++pages_in_use_ ) {
+			page_high_water_ = pages_in_use_;
+		}
+		frame_allocations_++;
+		return p;
+	}
+	void deallocate( void* p )
+	{
+		free_page* q = (free_page*)p;
+		q->next = free_pages_;
+		free_pages_ = q;
+		find_chunk( p ).used--;
+
+		pages_in_use_--;
+		frame_deallocations_++;
+	}
+
+	void begin_frame()
+	{
+		frame_allocations_ = 0;
+		frame_deallocations_ = 0;
+	}
+
+	// gpy[ŴȂ`N
+	//	 ߂l͉`N
+	size_t trim()
+	{
+		size_t n = 0;
+		for( size_t i = 0 ; i < chunks_.size() ; i++ ) {
+			if( chunks_[i].used == 0 ) { n++; }
+		}
+		if( n == 0 ) { return 0; }
+
+		// `Nɑy[W󂫃XgO
+		free_page* rest = NULL;
+		free_page* p = free_pages_;
+		while( p ) {
+			free_page* q = p->next;
+			if( find_chunk( p ).used != 0 ) {
+				p->next = rest;
+				rest = p;
+			}
+			p = q;
+		}
+		free_pages_ = rest;
+
+		size_t j = 0;
+		for( size_t i = 0 ; i < chunks_.size() ; i++ ) {
+			if( chunks_[i].used == 0 ) {
+				delete [] chunks_[i].raw;
+			} else {
+				chunks_[j++] = chunks_[i];
+			}
+		}
+		chunks_.resize( j );
+		return n;
+	}
+
+	void get_stats( stats_type& s ) const
+	{
+		s.chunk_count = chunks_.size();
+		s.page_count = chunks_.size() * pages_per_chunk_;
+		s.pages_in_use = pages_in_use_;
+		s.page_high_water = page_high_water_;
+		s.frame_allocations = frame_allocations_;
+		s.frame_deallocations = frame_deallocations_;
+	}
+
+private:
+	page_arena( const page_arena& ){}
+	void operator=( const page_arena& ){}
+
+	struct free_page {
+		free_page*	next;
+	};
+
+	struct chunk_type {
+		char*	raw;	// new[]
+		char*	begin;	// page_alignmentɑ擪
+		size_t	used;
+
+		bool operator<( const chunk_type& x ) const
+		{
+			return begin < x.begin;
+		}
+	};
+	typedef std::vector< chunk_type > chunks_type;
+
+	void add_chunk()
+	{
+		chunk_type c;
+		c.raw = new char[pages_per_chunk_ * page_size_ + page_alignment];
+		c.begin = c.raw + ( page_alignment - 1 ) -
+			( size_t( c.raw ) + ( page_alignment - 1 ) ) % page_alignment;
+		c.used = 0;
+
+		// 擪珇ɕo悤ɋtɐς
+		for( size_t i = pages_per_chunk_ ; 0 < i ; i-- ) {
+			free_page* p = (free_page*)( c.begin + ( i - 1 ) * page_size_ );
+			p->next = free_pages_;
+			free_pages_ = p;
+		}
+
+		chunks_.insert(
+			std::upper_bound( chunks_.begin(), chunks_.end(), c ), c );
+	}
+
+	chunk_type& find_chunk( void* p )
+	{
+		chunk_type c;
+		c.begin = (char*)p;
+		chunks_type::iterator i =
+			std::upper_bound( chunks_.begin(), chunks_.end(), c );
+		assert( i != chunks_.begin() );
+		--i;
+		assert( (char*)p < (*i).begin + pages_per_chunk_ * page_size_ );
+		return *i;
+	}
+
+private:
+	size_t						page_size_;
+	size_t						pages_per_chunk_;
+	chunks_type					chunks_;
+	free_page*					free_pages_;
+	size_t						pages_in_use_;
+	size_t						page_high_water_;
+	size_t						frame_allocations_;
+	size_t						frame_deallocations_;
+
+};
+
+// arena_page_provider
+//	 page_arena(w肪Ȃ΋L̂)y[W󂯎page_provider
+//	 fixed_pool::clearŃy[WԂ̂ŁÃׂs[Ntrimł
+
+class arena_page_provider {
+public:
+	arena_page_provider() : arena_( page_arena::instance() ) {}
+	arena_page_provider( page_arena& arena ) : arena_( arena ) {}
+	~arena_page_provider() {}
+
+	size_t page_size() { return arena_.page_size(); }
+	bool recycles_pages() { return true; }
+	void* allocate( size_t size ) { return arena_.allocate( size ); }
+	void deallocate( void* p ) { arena_.deallocate( p ); }
+
+	page_arena& get_arena() { return arena_; }
+
+private:
+	page_arena& arena_;
+
+};
+
+// frame_allocator
+//	 1t[̊Ԃgꎞ̈pbump allocator
+//	 ʂ̉͂Aresetł܂Ƃ߂Ċ߂(y[W͎)B
+//	 1y[WɎ܂Ȃ傫operator newɉ񂵁AresetŉB
+
+template < class PageProvider >
+class frame_allocator {
+private:
+	struct page_header {
+		page_header*	next;
+	};
+
+	// 㑱𑵂̗̈邽߁Awb_͂̑傫Ƃ݂Ȃ
+	enum { header_size = 16 };
+
+public:
+	frame_allocator( PageProvider& pp ) : page_provider_( pp )
+	{
+		pages_head_ = NULL;
+		current_ = NULL;
+		top_ = NULL;
+		end_ = NULL;
+		large_ = NULL;
+		oversize_count_ = 0;
+	}
+	~frame_allocator()
+	{
+		reset();
+		release();
+	}
+
+	void* allocate( size_t size )
+	{
+		size = ( size + ( sizeof( double ) - 1 ) ) &
+			~( sizeof( double ) - 1 );
+		if( end_ < top_ + size ) {
+			if( page_provider_.page_size() <
+				header_size + size ) {
+				return allocate_large( size );
+			}
+			next_page();
+		}
+
+		char* p = top_;
+		top_ += size;
+		return p;
+	}
+
+	// y[W̐擪Ɋ߂
+	void reset()
+	{
+		while( large_ ) {
+			page_header* q = large_->next;
+			delete [] ( (char*)large_ );
+			large_ = q;
+		}
+
+		current_ = NULL;
+		top_ = NULL;
+		end_ = NULL;
+	}
+
+	// ێĂy[Wpage_providerɕԂ(resetɌĂԂ)
+	void release()
+	{
+		assert( !current_ );
+		page_header* p = pages_head_;
+		while( p ) {
+			page_header* q = p->next;
+			page_provider_.deallocate( p );
+			p = q;
+		}
+		pages_head_ = NULL;
+	}
+
+	// 1y[WɎ܂炸operator newɉ񂵂
+	size_t oversize_count() const { return oversize_count_; }
+
+private:
+	void next_page()
+	{
+		page_header* p = current_ ? current_->next : pages_head_;
+		if( !p ) {
+			p = (page_header*)page_provider_.allocate(
+				page_provider_.page_size() );
+			p->next = NULL;
+			if( current_ ) {
+				current_->next = p;
+			} else {
+				pages_head_ = p;
+			}
+		}
+		current_ = p;
+		top_ = ( (char*)p ) + header_size;
+		end_ = ( (char*)p ) + page_provider_.page_size();
+	}
+
+	void* allocate_large( size_t size )
+	{
+		oversize_count_++;
+		page_header* p =
+			(page_header*)new char[header_size + size];
+		p->next = large_;
+		large_ = p;
+		return ( (char*)p ) + header_size;
+	}
+
+private:
+	frame_allocator( const frame_allocator& ){}
+	void operator=( const frame_allocator& ){}
+
+private:
+	PageProvider&	page_provider_;
+	page_header*	pages_head_;
+	page_header*	current_;
+	char*			top_;
+	char*			end_;
+	page_header*	large_;
+	size_t			oversize_count_;
+
+};
+
+// frame_stl_allocator
+//	 frame_allocatorSTLReig߂adaptor
+
+template < class T, class Allocator >
+class frame_stl_allocator {
+public:
+	typedef T				value_type;
+	typedef T*				pointer;
+	typedef const T*		const_pointer;
+	typedef T&				reference;
+	typedef const T&		const_reference;
+	typedef size_t			size_type;
+	typedef ptrdiff_t		difference_type;
+
+	template < class U > struct rebind {
+		typedef frame_stl_allocator< U, Allocator > other;
+	};
+
+public:
+	frame_stl_allocator( Allocator& a ) : allocator_( &a ) {}
+	template < class U >
+	frame_stl_allocator( const frame_stl_allocator< U, Allocator >& x )
+		: allocator_( x.get_allocator() ) {}
+
+	T* allocate( size_type n, const void* = 0 )
+	{
+		return (T*)allocator_->allocate( n * sizeof( T ) );
+	}
+	void deallocate( T*, size_type ) {}
+
+	size_type max_size() const { return size_type( -1 ) / sizeof( T ); }
+
+	Allocator* get_allocator() const { return allocator_; }
+
+	template < class U >
+	bool operator==( const frame_stl_allocator< U, Allocator >& x ) const
+	{
+		return allocator_ == x.get_allocator();
+	}
+	template < class U >
+	bool operator!=( const frame_stl_allocator< U, Allocator >& x ) const
+	{
+		return allocator_ != x.get_allocator();
+	}
+
+private:
+	Allocator*	allocator_;
+
+};
+
 
 #pragma pack(pop)
 
@@ -11,6 +11,7 @@
 #include <vector>
 #include <set>
 #include "partix_world.hpp"
+#include "partix_prefab.hpp"
 
 namespace partix {
 
@@ -31,6 +32,10 @@ struct package {
 	typedef Cloth< Traits >					cloth_type;
 	typedef BoundingPlane< Traits >			boundingplane_type;
 	typedef World< Traits >					world_type;
+	typedef Prefab< Traits >				prefab_type;
+	typedef PrefabRegistry< Traits >		prefab_registry_type;
+	typedef LodSelector< Traits >			lod_selector_type;
+	typedef DistanceLodSelector< Traits >	distance_lod_selector_type;
 };
 
 } // namespace partix
@@ -112,9 +112,7 @@ private:
 				bbmin_, bbmax_, s0, s1 ) ) {
 			points_type& points = cloud_->get_points();
 
-			SegmentTriangleSpatialHash< Traits > hash(
-				get_recommended_grid_size(), 4999 );
-			hash.add_segment( s0, s1 );
+			SegmentTrianglePicker< Traits > hash( s0, s1 );
 
 			for( typename faces_type::iterator i =
 					 faces_.begin() ;
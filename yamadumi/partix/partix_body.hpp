@@ -35,15 +35,9 @@ public:
 	Body()
 	{
 		id_			   = -1;
-		auto_freezing_ = false;
-		frozen_		   = false;
-		defrosting_	   = false;
-		global_force_  = force_ = math< Traits >::vector_zero();
-		dump_		   = 0.0f;
-		drag_		   = Traits::speed_drag_coefficient();
-		alive_		   = true;
-		positive_	   = true;
-		influential_   = true;
+		slot_		   = -1;
+		island_		   = -1;
+		reset_state();
 	}
 	virtual ~Body(){}
 
@@ -52,6 +46,10 @@ public:
 	virtual BodySnapShot< Traits >* make_snapshot() = 0;
 	virtual void apply_snapshot( const BodySnapShot< Traits >* ) = 0;
 
+	// bodymake_snapshotō̂ɏ㏑
+	// (World::set_adaptive_timestep̊߂pB蓖Ă)
+	virtual void store_snapshot( BodySnapShot< Traits >* ) = 0;
+
 	virtual void regularize() = 0;
 	virtual void list_collision_units(
 		std::vector< Collidable< Traits >* >& ) = 0;
@@ -63,7 +61,8 @@ public:
 	virtual void compute_motion(
 		real_type pdt, real_type dt, real_type idt ) = 0;
 	virtual void match_shape() =0;
-	virtual void restore_shape( real_type dt, real_type idt, int kmax ) = 0;
+	virtual void restore_shape(
+		real_type dt, real_type idt, int kmax, int passes ) = 0;
 	virtual void update_display_matrix() = 0;
 	virtual void update_frozen( real_type dt, real_type idt ) = 0;
 	virtual void end_frame() = 0;
@@ -75,9 +74,41 @@ public:
 	virtual void dump() {}
 	virtual void debug_check(){}
 
+	// ÕXebvł̌`̉(World::set_adaptive_timestepp)
+	virtual real_type get_distortion() { return 0; }
+
+	// Orestore_shapeł̖ڕWʒû̍ől
+	// (World::set_shape_iterationspB0Ȃ甽Ȃ)
+	virtual real_type get_shape_residual() { return 0; }
+
 	void set_id( int id ) { id_ = id; }
 	int	 get_id() { return id_; }
 
+	// World::bodies_̈ʒu(WorldȊO͐GȂ)
+	void set_slot( int slot ) { slot_ = slot; }
+	int	 get_slot() { return slot_; }
+
+	// Ăisland̔ԍANĂ-1(WorldȊO͐GȂ)
+	void set_island( int island ) { island_ = island; }
+	int	 get_island() { return island_; }
+
+	// ̏Ԃɖ߂(v[̍ėpp)
+	void reset_state()
+	{
+		auto_freezing_ = false;
+		frozen_		   = false;
+		defrosting_	   = false;
+		global_force_  = force_ = math< Traits >::vector_zero();
+		dump_		   = 0.0f;
+		drag_		   = Traits::speed_drag_coefficient();
+		alive_		   = true;
+		positive_	   = true;
+		influential_   = true;
+		collision_group_ = 1;
+		collision_mask_	 = ~0u;
+		actual_contact_list_.clear();
+	}
+
 	void set_features( bool alive, bool positive, bool influential )
 	{
 		set_alive( alive );
@@ -94,6 +125,22 @@ public:
 	void set_influential( bool f ) { influential_ = f; }
 	bool get_influential() { return influential_; }
 
+	// Փ˃tB^
+	//	 (group & mask)(group & mask)
+	//	 ǂ0łȂgՓ˂
+	void set_collision_filter( unsigned int group, unsigned int mask )
+	{
+		collision_group_ = group;
+		collision_mask_	 = mask;
+	}
+	unsigned int get_collision_group() { return collision_group_; }
+	unsigned int get_collision_mask() { return collision_mask_; }
+	bool test_collision_filter( const Body* y ) const
+	{
+		return ( collision_group_ & y->collision_mask_ ) &&
+			( y->collision_group_ & collision_mask_ );
+	}
+
 	void set_auto_freezing( bool f ) { auto_freezing_ = f; }
 	bool get_auto_freezing() { return auto_freezing_; }
 
@@ -121,6 +168,8 @@ public:
 
 private:
 	int				id_;
+	int				slot_;
+	int				island_;
 	vector_type		global_force_;
 	vector_type		force_;
 	real_type		dump_;
@@ -132,6 +181,8 @@ private:
 	bool			alive_;
 	bool			positive_;
 	bool			influential_;
+	unsigned int	collision_group_;
+	unsigned int	collision_mask_;
 
 };
 
@@ -5,6 +5,7 @@
 #include "partix_id.hpp"
 #include "partix_math.hpp"
 #include "partix_body.hpp"
+#include <algorithm>
 
 namespace partix {
 
@@ -62,6 +63,7 @@ public:
         touch_level_    = 2;
         current_center_ = initial_center_ = vector_type( 0, 0, 0 );
         average_edge_length_ = 0;
+        spring_iterations_ = 1;
     }
     ~Cloth() {}
 
@@ -76,6 +78,10 @@ public:
     {
         apply_snapshot_internal( ss );
     }
+    void store_snapshot( BodySnapShot< Traits >* ss )
+    {
+        store_snapshot_internal( ss );
+    }
 
     void regularize() { regularize_internal(); }
     void list_collision_units( collidables_type& s ) { s.push_back( this ); } 
@@ -89,9 +95,9 @@ public:
 		compute_motion_internal( pdt, dt, idt );
 	}
     void match_shape() {}
-    void restore_shape( real_type dt, real_type idt, int kmax )
+    void restore_shape( real_type dt, real_type idt, int kmax, int passes )
     {
-        restore_shape_internal( dt, idt, kmax );
+        restore_shape_internal( dt, idt, kmax, passes );
     }
     void end_frame() { end_frame_internal(); }
     
@@ -131,9 +137,28 @@ public:
     {
         spring_type s; s.indices.i0 = i0; s.indices.i1 = i1;
         springs_.push_back( s );
+        spring_batches_.clear();
     }
     springs_type& get_springs() { return springs_; }
 
+    // spring̍S1XebvɉJԂ
+    //   1(ftHg)Ȃ]ǂadd_spring̏ɉB
+    //   2ȏȂob`(PARTIX_PARALLELŕ)ɉB
+    //   ob`͏]̏x(񐔂Ə_炩)̂ŁA
+    //   ɂƂ͉񐔂𑝂₵Ďg
+    void    set_spring_iterations( int n )
+    {
+        assert( 1 <= n );
+        spring_iterations_ = n;
+    }
+    int     get_spring_iterations() { return spring_iterations_; }
+
+    // [_LȂspring̑g(ob`)̐
+    int     get_spring_batch_count()
+    {
+        return spring_batches_.empty() ? 0 : int( spring_batches_.size() ) - 1;
+    }
+
     void    add_face( int i0, int i1, int i2 )
     {
         face_type f; f.i0 = i0; f.i1 = i1; f.i2 = i2;
@@ -167,12 +192,20 @@ private:
         // LSnapShotɈړ
 
         ClothSnapShot< Traits >* ds = new ClothSnapShot< Traits >;
+        store_snapshot_internal( ds );
+        return ds;
+    }
+
+    void store_snapshot_internal( BodySnapShot< Traits >* ss )
+    {
+        ClothSnapShot< Traits >* ds =
+            dynamic_cast< ClothSnapShot< Traits >* >( ss );
+        assert( ds );
 
-        ds->clouds.push_back( *cloud_ );
+        ds->clouds.resize( 1 );
+        ds->clouds.front() = *cloud_;
         ds->initial_center = initial_center_;
         ds->global_force   = this->get_global_force();
-
-        return ds;
     }
 
     void apply_snapshot_internal( const BodySnapShot< Traits >* ss )
@@ -186,7 +219,8 @@ private:
         this->set_global_force( ds->global_force );
     }
 
-    void restore_shape_internal( real_type dt, real_type idt, int kmax )
+    void restore_shape_internal(
+        real_type dt, real_type idt, int kmax, int passes )
     {
         return;
 
@@ -261,26 +295,98 @@ private:
             drag_coefficient,
             1 );
 
+        for( int k = 0 ; k < spring_iterations_ ; k++ ) {
+            solve_springs();
+        }
+    }
+
+    void solve_springs()
+    {
         points_type& points = cloud_->get_points();
-        for( typename springs_type::const_iterator i = springs_.begin() ;
-             i != springs_.end() ;
-             ++i ) {
-            real_type dmax = real_type( 1.05 );
 
-            point_type& p0 = points[(*i).indices.i0];
-            point_type& p1 = points[(*i).indices.i1];
+        if( spring_iterations_ == 1 ) {
+            // 1񂾂Ȃ]̏(ςȂ悤)
+            for( typename springs_type::const_iterator i = springs_.begin() ;
+                 i != springs_.end() ;
+                 ++i ) {
+                solve_spring( points, *i );
+            }
+            return;
+        }
+
+        if( spring_batches_.empty() ) { make_spring_batches(); }
+
+        // ob`spring͒[_LȂ̂ŁA
+        // ob`ł͏ɈˑƗ()
+        int batch_count = int( spring_batches_.size() ) - 1;
+        for( int b = 0 ; b < batch_count ; b++ ) {
+            int begin = spring_batches_[b];
+            int end = spring_batches_[b+1];
+
+            PARTIX_PARALLEL_FOR
+            for( int j = begin ; j < end ; j++ ) {
+                solve_spring( points, springs_[spring_order_[j]] );
+            }
+        }
+    }
+
+    void solve_spring( points_type& points, const spring_type& s )
+    {
+        real_type dmax = real_type( 1.05 );
+
+        point_type& p0 = points[s.indices.i0];
+        point_type& p1 = points[s.indices.i1];
 
-            vector_type v = p1.new_position - p0.new_position;
-            real_type l = vector_traits::length( v );
-            vector_type u =
-                v * ( 1.0f / l ) * ( l - dmax * (*i).natural_length );
+        vector_type v = p1.new_position - p0.new_position;
+        real_type l = vector_traits::length( v );
+        vector_type u =
+            v * ( 1.0f / l ) * ( l - dmax * s.natural_length );
 
-            real_type m0 = p0.mass / ( p0.mass + p1.mass );
-            real_type m1 = p1.mass / ( p0.mass + p1.mass );
+        real_type m0 = p0.mass / ( p0.mass + p1.mass );
+        real_type m1 = p1.mass / ( p0.mass + p1.mass );
 
-            p0.new_position += u * m1;
-            p1.new_position -= u * m0;
-        }                
+        p0.new_position += u * m1;
+        p1.new_position -= u * m0;
+    }
+
+    void make_spring_batches()
+    {
+        // ×~@ɂӍʐF
+        //   espringɁAǂ̒[_ł܂gĂȂŏ̐F蓖Ă
+        int n = int( springs_.size() );
+        size_t point_count = cloud_->get_points().size();
+        std::vector< std::vector< int > > point_colors( point_count );
+        std::vector< int > colors( n );
+        std::vector< int > counts;
+        for( int i = 0 ; i < n ; i++ ) {
+            const std::vector< int >& c0 =
+                point_colors[springs_[i].indices.i0];
+            const std::vector< int >& c1 =
+                point_colors[springs_[i].indices.i1];
+
+            int c = 0;
+            while( std::find( c0.begin(), c0.end(), c ) != c0.end() ||
+                   std::find( c1.begin(), c1.end(), c ) != c1.end() ) {
+                c++;
+            }
+            colors[i] = c;
+            point_colors[springs_[i].indices.i0].push_back( c );
+            point_colors[springs_[i].indices.i1].push_back( c );
+            if( int( counts.size() ) <= c ) { counts.resize( c + 1, 0 ); }
+            counts[c]++;
+        }
+
+        // FƂɕׂ(F̒ł͌̏ۂ)
+        spring_batches_.assign( counts.size() + 1, 0 );
+        for( size_t c = 0 ; c < counts.size() ; c++ ) {
+            spring_batches_[c+1] = spring_batches_[c] + counts[c];
+        }
+        std::vector< int > cursor( spring_batches_.begin(),
+                                   spring_batches_.end() - 1 );
+        spring_order_.resize( n );
+        for( int i = 0 ; i < n ; i++ ) {
+            spring_order_[cursor[colors[i]]++] = i;
+        }
     }
 
 
@@ -352,6 +458,9 @@ private:
     void end_frame_internal()
     {
         touch_level_ = 0;
+
+        // ʖ@͂̃Xebv̍ŏIʒuō蒼
+        this->invalidate_face_normals();
     }
 
     void move_internal( const vector_type& v )
@@ -423,6 +532,8 @@ private:
             total_edge_length += (*i).natural_length;
         }
         average_edge_length_ = total_edge_length / springs_.size();                
+
+        make_spring_batches();
     }
 
     void calculate_initial_center()
@@ -493,9 +604,7 @@ private:
         if( math< Traits >::test_aabb_segment( bbmin_, bbmax_, s0, s1 ) ) {
             const points_type& points = get_cloud()->get_points();
 
-            SegmentTriangleSpatialHash< Traits > hash(
-                average_edge_length_, 4999 );
-            hash.add_segment( s0, s1 );
+            SegmentTrianglePicker< Traits > hash( s0, s1 );
             for( typename faces_type::const_iterator i = faces_.begin() ;
                  i != faces_.end() ;
                  ++i ) {
@@ -606,6 +715,9 @@ public:
     cloud_type*     cloud_;
     indices_type    indices_;
     springs_type    springs_;
+    std::vector< int > spring_order_;   // ob`ɕׂspringindex
+    std::vector< int > spring_batches_; // ob`̐擪(spring_order_)
+    int             spring_iterations_;
     faces_type      faces_;
     real_type       thickness_;
 
@@ -10,6 +10,7 @@
 
 #include "partix_forward.hpp"
 #include "partix_geometry.hpp"
+#include "partix_cloud.hpp"
 
 namespace partix{
 
@@ -20,8 +21,15 @@ public:
 	typedef typename Traits::index_type				index_type;
 	typedef std::vector< index_type >				indices_type;
 	typedef std::vector< Face< Traits > >			faces_type;
+	typedef typename Traits::vector_type			vector_type;
+	typedef std::vector< vector_type >				normals_type;
 
 public:
+	Collidable()
+	{
+		ray_epoch_ = triangle_epoch_ = 0;
+		face_normals_valid_ = false;
+	}
 	virtual ~Collidable() {}
 		
 	virtual Body< Traits >*					get_body() = 0;
@@ -43,6 +51,62 @@ public:
 	virtual void							mark() = 0;
 	virtual void							unmark() = 0;
 	virtual bool							marked() = 0;
+
+	// RayProcessoȑdp
+	//	 epochŊɈ󂪂Ăfalse
+	bool mark_ray( unsigned int epoch )
+	{
+		if( ray_epoch_ == epoch ) { return false; }
+		ray_epoch_ = epoch;
+		return true;
+	}
+	bool mark_triangle( unsigned int epoch )
+	{
+		if( triangle_epoch_ == epoch ) { return false; }
+		triangle_epoch_ = epoch;
+		return true;
+	}
+
+	// ʖ@(PʃxNgAget_faces()Ɠ)
+	//	 Worldbroad phasebodyend_frameŖɂA
+	//	 ŏɎgꂽƂɌvZB
+	//	 ray processorAcontactA`Ȃǂ͂g
+	const normals_type& get_face_normals()
+	{
+		if( !face_normals_valid_ ) {
+			make_face_normals();
+		}
+		return face_normals_;
+	}
+	void invalidate_face_normals() { face_normals_valid_ = false; }
+
+private:
+	void make_face_normals()
+	{
+		const faces_type& faces = get_faces();
+		const typename Cloud< Traits >::points_type& points =
+			get_cloud()->get_points();
+
+		normals_type& normals = face_normals_;
+		int n = int( faces.size() );
+		normals.resize( n );
+		for( int i = 0 ; i < n ; i++ ) {
+			const Face< Traits >& f = faces[i];
+			const vector_type& v0 = points[f.i0].new_position;
+			const vector_type& v1 = points[f.i1].new_position;
+			const vector_type& v2 = points[f.i2].new_position;
+			normals[i] = math< Traits >::normalize(
+				math< Traits >::cross( v1 - v0, v2 - v0 ) );
+		}
+		face_normals_valid_ = true;
+	}
+
+private:
+	unsigned int	ray_epoch_;
+	unsigned int	triangle_epoch_;
+	normals_type	face_normals_;
+	bool			face_normals_valid_;
+
 };
 
 } // namespace partix 
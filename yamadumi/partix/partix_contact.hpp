@@ -9,6 +9,7 @@
 #define PARTIX_CONTACT_HPP
 
 #include "partix_forward.hpp"
+#include <vector>
 
 namespace partix {
 
@@ -29,6 +30,10 @@ public:
 	real_type				w; // barycentric coordinates for p2
 	real_type				t; // intersect. pos = ap->penetration_vector * t;
 	real_type				alpha; // pushout factor
+	real_type				mass; // A̎(World::set_contact_reductionő\ɏW߂܂)
+	vector_type				penetration_vector; // oɎg(\ł͎ʏdݕt)
+	vector_type				displacement; // apply_contactsA_pointۂɓ
+	int						age; // (A_point, Op`)ŘAĐڐGt[
 
 	void check()
 	{
@@ -45,6 +50,222 @@ public:
 		
 };
 
+// ContactCache
+//	 Ot[contact(A_point, BOp`)L[ɊoĂB
+//	 A_pointƂɍŋ߂contact͈Ȃ̂ŁA\A_pointŃnbV
+//	 Op`͏ƍɎgB\͓ʎŁAflipō񕪂O񕪂ɂB
+//	 Point̃AhXL[ɂ̂ŁAbody폜remove_body邱
+
+template < class Traits >
+class ContactCache {
+public:
+	typedef typename Traits::real_type		real_type;
+	typedef typename Traits::vector_type	vector_type;
+	typedef Point< Traits >					point_type;
+	typedef Body< Traits >					body_type;
+	typedef Contact< Traits >				contact_type;
+
+	struct entry_type {
+		point_type*		A_point; // NULLȂ
+		point_type*		B_point0;
+		point_type*		B_point1;
+		point_type*		B_point2;
+		body_type*		A_body;
+		body_type*		B_body;
+		vector_type		penetration_vector;
+		real_type		u;
+		real_type		v;
+		real_type		w;
+		real_type		t;
+		int				age;
+	};
+	typedef std::vector< entry_type >		entries_type;
+
+public:
+	ContactCache()
+	{
+		current_count_ = previous_count_ = 0;
+		resize( current_, 256 );
+		resize( previous_, 256 );
+	}
+
+	// 񕪂O񕪂ɂāA񕪂ɂ
+	void flip()
+	{
+		std::swap( current_, previous_ );
+		previous_count_ = current_count_;
+		current_count_ = 0;
+		for( typename entries_type::iterator i = current_.begin() ;
+			 i != current_.end() ;
+			 ++i ) {
+			(*i).A_point = NULL;
+		}
+	}
+
+	// Oflip(񕪂̂ĂđO񕪂񕪂ɖ߂)
+	//	 World::set_adaptive_timestepŃXebv߂Ƃp
+	void unflip()
+	{
+		std::swap( current_, previous_ );
+		current_count_ = previous_count_;
+		previous_count_ = 0;
+		for( typename entries_type::iterator i = previous_.begin() ;
+			 i != previous_.end() ;
+			 ++i ) {
+			(*i).A_point = NULL;
+		}
+	}
+
+	// O񕪂񕪂̂Ă
+	void clear()
+	{
+		flip();
+		flip();
+	}
+
+	// body̓_ʂ܂ނ̂O񕪁A񕪂菜
+	void remove_body( const body_type* b )
+	{
+		remove_body( current_, current_count_, b );
+		remove_body( previous_, previous_count_, b );
+	}
+
+	// O񕪂T
+	const entry_type* find( point_type* A_point ) const
+	{
+		if( previous_count_ == 0 ) { return NULL; }
+
+		size_t mask = previous_.size() - 1;
+		for( size_t k = hash( A_point ) & mask ; ; k = ( k + 1 ) & mask ) {
+			const entry_type& e = previous_[k];
+			if( e.A_point == A_point ) { return &e; }
+			if( !e.A_point ) { return NULL; }
+		}
+	}
+
+	const entry_type* find(
+		point_type* A_point,
+		point_type* B_point0,
+		point_type* B_point1,
+		point_type* B_point2 ) const
+	{
+		const entry_type* e = find( A_point );
+		if( !e ||
+			e->B_point0 != B_point0 ||
+			e->B_point1 != B_point1 ||
+			e->B_point2 != B_point2 ) {
+			return NULL;
+		}
+		return e;
+	}
+
+	// 񕪂ɋL^(A_point͏㏑)
+	void store( const contact_type& c )
+	{
+		if( current_.size() < ( current_count_ + 1 ) * 2 ) {
+			grow();
+		}
+
+		size_t mask = current_.size() - 1;
+		size_t k = hash( c.A_point ) & mask;
+		while( current_[k].A_point && current_[k].A_point != c.A_point ) {
+			k = ( k + 1 ) & mask;
+		}
+
+		entry_type& e = current_[k];
+		if( !e.A_point ) { current_count_++; }
+		e.A_point				= c.A_point;
+		e.B_point0				= c.B_point0;
+		e.B_point1				= c.B_point1;
+		e.B_point2				= c.B_point2;
+		e.A_body				= c.A_body;
+		e.B_body				= c.B_body;
+		e.penetration_vector	= c.A_point->penetration_vector;
+		e.u						= c.u;
+		e.v						= c.v;
+		e.w						= c.w;
+		e.t						= c.t;
+		e.age					= c.age;
+	}
+
+	int get_count() { return int( current_count_ ); }
+
+private:
+	static size_t hash( const point_type* p )
+	{
+		// Point͔zɕł̂ŘAԂɂȂ
+		return size_t( p ) / sizeof( point_type );
+	}
+
+	static void resize( entries_type& entries, size_t n )
+	{
+		entries.resize( n );
+		for( typename entries_type::iterator i = entries.begin() ;
+			 i != entries.end() ;
+			 ++i ) {
+			(*i).A_point = NULL;
+		}
+	}
+
+	static void remove_body(
+		entries_type& entries, size_t& count, const body_type* b )
+	{
+		if( count == 0 ) { return; }
+
+		size_t n = entries.size();
+		size_t mask = n - 1;
+		size_t removed = 0;
+		size_t empty = n;
+		for( size_t k = 0 ; k < n ; k++ ) {
+			entry_type& e = entries[k];
+			if( e.A_point && ( e.A_body == b || e.B_body == b ) ) {
+				e.A_point = NULL;
+				removed++;
+			}
+			if( !e.A_point && empty == n ) { empty = k; }
+		}
+		if( removed == 0 ) { return; }
+		count -= removed;
+
+		// T̗񂪓r؂Ȃ悤A󂫂̎ċlߒ
+		for( size_t j = 1 ; j < n ; j++ ) {
+			size_t k = ( empty + j ) & mask;
+			if( !entries[k].A_point ) { continue; }
+			entry_type e = entries[k];
+			entries[k].A_point = NULL;
+			size_t h = hash( e.A_point ) & mask;
+			while( entries[h].A_point ) { h = ( h + 1 ) & mask; }
+			entries[h] = e;
+		}
+	}
+
+	void grow()
+	{
+		entries_type old;
+		old.swap( current_ );
+		resize( current_, old.size() * 2 );
+		current_count_ = 0;
+
+		size_t mask = current_.size() - 1;
+		for( typename entries_type::const_iterator i = old.begin() ;
+			 i != old.end() ;
+			 ++i ) {
+			if( !(*i).A_point ) { continue; }
+			size_t k = hash( (*i).A_point ) & mask;
+			while( current_[k].A_point ) { k = ( k + 1 ) & mask; }
+			current_[k] = *i;
+			current_count_++;
+		}
+	}
+
+private:
+	entries_type	current_;
+	entries_type	previous_;
+	size_t			current_count_;
+	size_t			previous_count_;
+
+};
+
 } // namespace partix
 
 #endif // PARTIX_CONTACT_HPP
@@ -8,6 +8,15 @@
 #ifndef PARTIX_FORWARD_HPP
 #define PARTIX_FORWARD_HPP
 
+// ƗȔɉ(World::apply_contactsACloth::solve_springsȂ)
+//   OpenMPLɂPARTIX_PARALLEL`Ƃ̂݁B
+//   g͔ǂ_ɏȂ悤ɂĂ
+#if defined( _OPENMP ) && defined( PARTIX_PARALLEL )
+#define PARTIX_PARALLEL_FOR _Pragma( "omp parallel for" )
+#else
+#define PARTIX_PARALLEL_FOR
+#endif
+
 namespace partix {
 
 template < class Traits > class Collidable;
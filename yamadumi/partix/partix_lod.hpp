@@ -0,0 +1,395 @@
+/*!
+  @file		partix_lod.hpp
+  @brief	<Tv>
+
+  SoftVolumȅڍדx(LOD)؂ւp̕i
+*/
+#ifndef PARTIX_LOD_HPP
+#define PARTIX_LOD_HPP
+
+#include "partix_forward.hpp"
+#include "partix_tetrahedral_mesh.hpp"
+#include "partix_softvolume.hpp"
+#include <algorithm>
+#include <map>
+#include <set>
+#include <vector>
+
+namespace partix {
+
+// TetrahedralEmbedding
+//	 bVB̊e_AbVAtetrahedron̏dSWŕ\́B
+//	 ʒu(source_position)ňxAAB֏Ԃʂ̂ɎgB
+//	 ÅOɂ_͈ԋ߂tetrahedronŊO}
+template < class Traits >
+class TetrahedralEmbedding {
+public:
+	typedef typename Traits::real_type		real_type;
+	typedef typename Traits::vector_type	vector_type;
+	typedef typename Traits::index_type		index_type;
+	typedef TetrahedralMesh< Traits >		mesh_type;
+	typedef typename mesh_type::points_type points_type;
+	typedef typename mesh_type::tetrahedron_type tetrahedron_type;
+	typedef typename mesh_type::tetrahedra_type tetrahedra_type;
+
+	struct entry_type {
+		index_type	i[4];
+		real_type	w[4];
+	};
+	typedef std::vector< entry_type > entries_type;
+
+public:
+	TetrahedralEmbedding() {}
+	~TetrahedralEmbedding() {}
+
+	void build( mesh_type* a, mesh_type* b )
+	{
+		const points_type& apoints = a->get_points();
+		const points_type& bpoints = b->get_points();
+		const tetrahedra_type& tetrahedra = a->get_tetrahedra();
+		assert( !tetrahedra.empty() );
+
+		entries_.resize( bpoints.size() );
+		for( size_t j = 0 ; j < bpoints.size() ; j++ ) {
+			const vector_type& q = bpoints[j].source_position;
+
+			// dSW̍ŏlԑ傫(=ԓ)I
+			real_type best = -math< Traits >::real_max();
+			entry_type& e = entries_[j];
+			for( typename tetrahedra_type::const_iterator i =
+					 tetrahedra.begin() ;
+				 i != tetrahedra.end() ;
+				 ++i ) {
+				const tetrahedron_type& t = *i;
+				real_type w[4];
+				if( !barycentric(
+						apoints[t.i0].source_position,
+						apoints[t.i1].source_position,
+						apoints[t.i2].source_position,
+						apoints[t.i3].source_position,
+						q, w ) ) {
+					continue;
+				}
+
+				real_type m = w[0];
+				for( int k = 1 ; k < 4 ; k++ ) {
+					if( w[k] < m ) { m = w[k]; }
+				}
+				if( best < m ) {
+					best = m;
+					e.i[0] = t.i0;
+					e.i[1] = t.i1;
+					e.i[2] = t.i2;
+					e.i[3] = t.i3;
+					for( int k = 0 ; k < 4 ; k++ ) { e.w[k] = w[k]; }
+				}
+			}
+			assert( -math< Traits >::real_max() < best );
+		}
+	}
+
+	// äʒuExECbɎʂ
+	void transfer( mesh_type* a, mesh_type* b ) const
+	{
+		const points_type& apoints = a->get_points();
+		points_type& bpoints = b->get_points();
+		assert( entries_.size() == bpoints.size() );
+
+		vector_type v0 = math< Traits >::vector_zero();
+		for( size_t j = 0 ; j < bpoints.size() ; j++ ) {
+			const entry_type& e = entries_[j];
+			typename mesh_type::point_type& p = bpoints[j];
+
+			p.new_position = v0;
+			p.old_position = v0;
+			p.velocity = v0;
+			int nearest = 0;
+			for( int k = 0 ; k < 4 ; k++ ) {
+				const typename mesh_type::point_type& s = apoints[e.i[k]];
+				p.new_position += s.new_position * e.w[k];
+				p.old_position += s.old_position * e.w[k];
+				p.velocity += s.velocity * e.w[k];
+				if( e.w[nearest] < e.w[k] ) { nearest = k; }
+			}
+
+			// O}ƕɂȂ肤̂ňԋ߂_̂̂g
+			p.friction = apoints[e.i[nearest]].friction;
+		}
+	}
+
+	const entries_type& get_entries() { return entries_; }
+
+private:
+	static bool barycentric(
+		const vector_type& a,
+		const vector_type& b,
+		const vector_type& c,
+		const vector_type& d,
+		const vector_type& q,
+		real_type* w )
+	{
+		vector_type ab = b - a;
+		vector_type ac = c - a;
+		vector_type ad = d - a;
+		vector_type aq = q - a;
+
+		real_type volume =
+			math< Traits >::dot( ab, math< Traits >::cross( ac, ad ) );
+		if( std::abs( volume ) < math< Traits >::epsilon() ) {
+			return false;
+		}
+
+		real_type ivolume = real_type( 1.0 ) / volume;
+		w[1] = math< Traits >::dot(
+			aq, math< Traits >::cross( ac, ad ) ) * ivolume;
+		w[2] = math< Traits >::dot(
+			ab, math< Traits >::cross( aq, ad ) ) * ivolume;
+		w[3] = math< Traits >::dot(
+			ab, math< Traits >::cross( ac, aq ) ) * ivolume;
+		w[0] = real_type( 1.0 ) - w[1] - w[2] - w[3];
+		return true;
+	}
+
+private:
+	entries_type	entries_;
+
+};
+
+// make_lattice_mesh
+//	 ׂbV̓_ފiq̑ebVB
+//	 divisions͈Ԓӂ̃̕ZŁA_܂ރZ
+//	 5tetrahedronɕ(ׂ̃ZƑΊp悤Ōς)B
+//	 ʂ̍v͌̃bVƓɂ
+template < class Traits >
+TetrahedralMesh< Traits >* make_lattice_mesh(
+	TetrahedralMesh< Traits >* fine, int divisions )
+{
+	typedef typename Traits::real_type			real_type;
+	typedef typename Traits::vector_type		vector_type;
+	typedef typename Traits::vector_traits		vector_traits;
+	typedef typename Traits::index_type			index_type;
+	typedef TetrahedralMesh< Traits >			mesh_type;
+	typedef typename mesh_type::points_type		points_type;
+
+	assert( 0 < divisions );
+
+	const points_type& points = fine->get_points();
+	assert( !points.empty() );
+
+	vector_type bbmin = math< Traits >::vector_max();
+	vector_type bbmax = math< Traits >::vector_min();
+	real_type mass = 0;
+	for( typename points_type::const_iterator i = points.begin() ;
+		 i != points.end() ;
+		 ++i ) {
+		math< Traits >::update_bb( bbmin, bbmax, (*i).source_position );
+		mass += (*i).mass;
+	}
+
+	// E̓_͂ݏoȂ悤ɏL
+	vector_type extent = bbmax - bbmin;
+	real_type longest = vector_traits::x( extent );
+	if( longest < vector_traits::y( extent ) ) {
+		longest = vector_traits::y( extent );
+	}
+	if( longest < vector_traits::z( extent ) ) {
+		longest = vector_traits::z( extent );
+	}
+	real_type margin = longest * real_type( 0.01 );
+	vector_type m = vector_traits::make_vector( margin, margin, margin );
+	bbmin -= m;
+	bbmax += m;
+	extent = bbmax - bbmin;
+
+	real_type h = ( longest + margin * 2 ) / divisions;
+	int n[3] = {
+		std::max( 1, int( ceil( vector_traits::x( extent ) / h ) ) ),
+		std::max( 1, int( ceil( vector_traits::y( extent ) / h ) ) ),
+		std::max( 1, int( ceil( vector_traits::z( extent ) / h ) ) ),
+	};
+
+	// _܂ރZ
+	std::set< int > cells;
+	for( typename points_type::const_iterator i = points.begin() ;
+		 i != points.end() ;
+		 ++i ) {
+		vector_type d = (*i).source_position - bbmin;
+		int c[3] = {
+			std::min( n[0] - 1, int( vector_traits::x( d ) / h ) ),
+			std::min( n[1] - 1, int( vector_traits::y( d ) / h ) ),
+			std::min( n[2] - 1, int( vector_traits::z( d ) / h ) ),
+		};
+		cells.insert( ( c[2] * n[1] + c[1] ) * n[0] + c[0] );
+	}
+
+	// Z̊pɓ_
+	std::map< int, index_type > corners;
+	for( std::set< int >::const_iterator i = cells.begin() ;
+		 i != cells.end() ;
+		 ++i ) {
+		int cx = *i % n[0];
+		int cy = *i / n[0] % n[1];
+		int cz = *i / n[0] / n[1];
+		for( int k = 0 ; k < 8 ; k++ ) {
+			int x = cx + ( k & 1 );
+			int y = cy + ( ( k >> 1 ) & 1 );
+			int z = cz + ( ( k >> 2 ) & 1 );
+			corners[ ( z * ( n[1] + 1 ) + y ) * ( n[0] + 1 ) + x ] = 0;
+		}
+	}
+
+	mesh_type* coarse = new mesh_type;
+	real_type point_mass = mass / real_type( corners.size() );
+	index_type index = 0;
+	for( typename std::map< int, index_type >::iterator i = corners.begin() ;
+		 i != corners.end() ;
+		 ++i ) {
+		int x = (*i).first % ( n[0] + 1 );
+		int y = (*i).first / ( n[0] + 1 ) % ( n[1] + 1 );
+		int z = (*i).first / ( n[0] + 1 ) / ( n[1] + 1 );
+		coarse->add_point(
+			bbmin + vector_traits::make_vector( x * h, y * h, z * h ),
+			point_mass );
+		(*i).second = index++;
+	}
+
+	// p̔ԍx, y, z̃rbg
+	static const int even[5][4] = {
+		{ 1, 2, 4, 7 },
+		{ 0, 1, 2, 4 },
+		{ 3, 1, 2, 7 },
+		{ 5, 1, 4, 7 },
+		{ 6, 2, 4, 7 },
+	};
+	static const int odd[5][4] = {
+		{ 0, 3, 5, 6 },
+		{ 1, 0, 3, 5 },
+		{ 2, 0, 3, 6 },
+		{ 4, 0, 5, 6 },
+		{ 7, 3, 5, 6 },
+	};
+
+	// ʂ1񂵂oĂȂtetrahedron̖
+	//	 @(cross(v1-v0, v2-v0))͓ǂݍ񂾃bVƓ
+	typedef std::map< std::set< index_type >, std::vector< index_type > >
+		faces_type;
+	faces_type faces;
+	for( std::set< int >::const_iterator i = cells.begin() ;
+		 i != cells.end() ;
+		 ++i ) {
+		int cx = *i % n[0];
+		int cy = *i / n[0] % n[1];
+		int cz = *i / n[0] / n[1];
+
+		index_type v[8];
+		for( int k = 0 ; k < 8 ; k++ ) {
+			int x = cx + ( k & 1 );
+			int y = cy + ( ( k >> 1 ) & 1 );
+			int z = cz + ( ( k >> 2 ) & 1 );
+			v[k] = corners[ ( z * ( n[1] + 1 ) + y ) * ( n[0] + 1 ) + x ];
+		}
+
+		const int (*table)[4] = ( ( cx + cy + cz ) & 1 ) ? odd : even;
+		for( int j = 0 ; j < 5 ; j++ ) {
+			index_type t[4] = {
+				v[table[j][0]], v[table[j][1]],
+				v[table[j][2]], v[table[j][3]] };
+			coarse->add_tetrahedron( t[0], t[1], t[2], t[3] );
+
+			for( int k = 0 ; k < 4 ; k++ ) {
+				index_type f0 = t[( k + 1 ) % 4];
+				index_type f1 = t[( k + 2 ) % 4];
+				index_type f2 = t[( k + 3 ) % 4];
+				const points_type& cp = coarse->get_points();
+				vector_type a = cp[f0].source_position;
+				vector_type nrm = math< Traits >::cross(
+					cp[f1].source_position - a,
+					cp[f2].source_position - a );
+				if( math< Traits >::dot(
+						nrm, cp[t[k]].source_position - a ) < 0 ) {
+					std::swap( f1, f2 );
+				}
+
+				std::set< index_type > key;
+				key.insert( f0 );
+				key.insert( f1 );
+				key.insert( f2 );
+				std::vector< index_type >& f = faces[key];
+				if( f.empty() ) {
+					f.push_back( f0 );
+					f.push_back( f1 );
+					f.push_back( f2 );
+				} else {
+					// ̖
+					f.push_back( -1 );
+				}
+			}
+		}
+	}
+
+	for( typename faces_type::const_iterator i = faces.begin() ;
+		 i != faces.end() ;
+		 ++i ) {
+		const std::vector< index_type >& f = (*i).second;
+		if( f.size() != 3 ) { continue; }
+		coarse->add_face( f[0], f[1], f[2] );
+	}
+
+	coarse->setup();
+	return coarse;
+}
+
+// LodSelector
+//	 spawnSoftVolumeƂɎgڍדx߂tbNB
+//	 0ׂbVA1ebV
+template < class Traits >
+class LodSelector {
+public:
+	virtual ~LodSelector() {}
+	virtual int select( SoftVolume< Traits >* v, int current_level ) = 0;
+};
+
+// DistanceLodSelector
+//	 _̋őIԁBEł΂Ȃ悤
+//	 êfarÂׂnearɂ
+template < class Traits >
+class DistanceLodSelector : public LodSelector< Traits > {
+public:
+	typedef typename Traits::real_type		real_type;
+	typedef typename Traits::vector_type	vector_type;
+
+public:
+	DistanceLodSelector(
+		const vector_type&	view_point,
+		real_type			near_distance,
+		real_type			far_distance )
+		: view_point_( view_point ),
+		  near_( near_distance ),
+		  far_( far_distance )
+	{
+		assert( near_distance <= far_distance );
+	}
+
+	void set_view_point( const vector_type& v ) { view_point_ = v; }
+
+	int select( SoftVolume< Traits >* v, int current_level )
+	{
+		real_type d = math< Traits >::length_sq(
+			v->get_current_center() - view_point_ );
+		if( current_level == 0 ) {
+			return far_ * far_ < d ? 1 : 0;
+		} else {
+			return d < near_ * near_ ? 0 : 1;
+		}
+	}
+
+private:
+	vector_type view_point_;
+	real_type	near_;
+	real_type	far_;
+
+};
+
+} // namespace partix
+
+#endif // PARTIX_LOD_HPP
@@ -414,6 +414,88 @@ struct math {
 		vector_traits::z( dst, m[6] * src.x + m[7] * src.y + m[8] * src.z );
 	}
 
+	// ]xNg(Apx)]s
+	static void make_rotation_matrix( real_type* dst, const vector_type& w )
+	{
+		real_type x = vector_traits::x( w );
+		real_type y = vector_traits::y( w );
+		real_type z = vector_traits::z( w );
+		real_type theta = real_type( sqrt( x * x + y * y + z * z ) );
+		if( theta < epsilon() ) {
+			dst[0] = 1;	 dst[1] = -z; dst[2] = y;
+			dst[3] = z;	 dst[4] = 1;  dst[5] = -x;
+			dst[6] = -y; dst[7] = x;  dst[8] = 1;
+			return;
+		}
+
+		real_type it = real_type( 1.0 ) / theta;
+		x *= it; y *= it; z *= it;
+		real_type c = real_type( cos( theta ) );
+		real_type s = real_type( sin( theta ) );
+		real_type t = real_type( 1.0 ) - c;
+
+		dst[0] = c + t * x * x;
+		dst[1] = t * x * y - s * z;
+		dst[2] = t * x * z + s * y;
+		dst[3] = t * y * x + s * z;
+		dst[4] = c + t * y * y;
+		dst[5] = t * y * z - s * x;
+		dst[6] = t * z * x - s * y;
+		dst[7] = t * z * y + s * x;
+		dst[8] = c + t * z * z;
+	}
+
+	// Ả]RARlɂŋ߂
+	//	 ÕXebv̉]n߂ΐŎB
+	//	 sqrt_matrixɂɕƈႢAʂ͏(fłȂ)]ɂȂ
+	static void extract_rotation(
+		real_type* R, const real_type* A, int iterations )
+	{
+		for( int n = 0 ; n < iterations ; n++ ) {
+			// eɂ r ~ a ̘a rEa ̘aŊ̂]̏C
+			real_type wx = 0, wy = 0, wz = 0, d = 0;
+			for( int j = 0 ; j < 3 ; j++ ) {
+				real_type rx = R[j], ry = R[3 + j], rz = R[6 + j];
+				real_type ax = A[j], ay = A[3 + j], az = A[6 + j];
+				wx += ry * az - rz * ay;
+				wy += rz * ax - rx * az;
+				wz += rx * ay - ry * ax;
+				d += rx * ax + ry * ay + rz * az;
+			}
+			real_type id = real_type( 1.0 ) / ( std::abs( d ) + epsilon() );
+			vector_type w;
+			vector_traits::x( w, wx * id );
+			vector_traits::y( w, wy * id );
+			vector_traits::z( w, wz * id );
+			if( length_sq( w ) < epsilon() * epsilon() ) { break; }
+
+			real_type dR[9];
+			real_type R1[9];
+			make_rotation_matrix( dR, w );
+			multiply_matrix( R1, dR, R );
+			copy_matrix( R, R1 );
+		}
+		orthonormalize_matrix( R );
+	}
+
+	// ]š덷̒~ς菜(sGram-SchmidtŒ)
+	static void orthonormalize_matrix( real_type* m )
+	{
+		real_type l0 = real_type( 1.0 ) /
+			real_type( sqrt( m[0] * m[0] + m[1] * m[1] + m[2] * m[2] ) );
+		m[0] *= l0; m[1] *= l0; m[2] *= l0;
+
+		real_type d = m[0] * m[3] + m[1] * m[4] + m[2] * m[5];
+		m[3] -= m[0] * d; m[4] -= m[1] * d; m[5] -= m[2] * d;
+		real_type l1 = real_type( 1.0 ) /
+			real_type( sqrt( m[3] * m[3] + m[4] * m[4] + m[5] * m[5] ) );
+		m[3] *= l1; m[4] *= l1; m[5] *= l1;
+
+		m[6] = m[1] * m[5] - m[2] * m[4];
+		m[7] = m[2] * m[3] - m[0] * m[5];
+		m[8] = m[0] * m[4] - m[1] * m[3];
+	}
+
 	static real_type epsilon() { return real_type( 0.000001 ); }
 	static real_type real_min()
 	{
@@ -700,6 +782,27 @@ struct math {
 
 		return std::abs( s ) <= r;
 	}
+
+	// AABB̈ꕔłʂ̗(@Ƌt)ɂtrue
+	static bool test_aabb_halfspace( const vector_type& bbmin,
+									 const vector_type& bbmax,
+									 const vector_type& plane_position,
+									 const vector_type& plane_normal )
+	{
+		vector_type c = ( bbmin + bbmax ) * real_type( 0.5 );
+		vector_type e = bbmax - c;
+
+		real_type r =
+			e.x * std::abs( plane_normal.x ) +
+			e.y * std::abs( plane_normal.y ) +
+			e.z * std::abs( plane_normal.z );
+
+		real_type s =
+			dot( plane_normal, c ) -
+			dot( plane_normal, plane_position );
+
+		return s <= r;
+	}
                                         
 	static bool test_aabb_aabb(
 		const vector_type& mn0, const vector_type& mx0,
@@ -720,6 +823,20 @@ struct math {
 			mn0.z <= q.z && q.z <= mx0.z;
 	}
 
+	static bool test_aabb_sphere(
+		const vector_type& mn0, const vector_type& mx0,
+		const vector_type& center, real_type radius )
+	{
+		real_type d = 0;
+		if( center.x < mn0.x ) { d += square( mn0.x - center.x ); }
+		else if( mx0.x < center.x ) { d += square( center.x - mx0.x ); }
+		if( center.y < mn0.y ) { d += square( mn0.y - center.y ); }
+		else if( mx0.y < center.y ) { d += square( center.y - mx0.y ); }
+		if( center.z < mn0.z ) { d += square( mn0.z - center.z ); }
+		else if( mx0.z < center.z ) { d += square( center.z - mx0.z ); }
+		return d <= square( radius );
+	}
+
 	static bool test_segment_triangle( const vector_type& r0,
 									   const vector_type& r1,
 									   const vector_type& v0,
@@ -49,6 +49,7 @@ public:
         return new BoundingPlaneSnapShot< Traits >;
     }
     void apply_snapshot( const BodySnapShot< Traits >* ) { }
+    void store_snapshot( BodySnapShot< Traits >* ) { }
 
     void            regularize() {}
     matrix_type     get_world_matrix() { return matrix_type(); }
@@ -64,7 +65,7 @@ public:
 	void			compute_motion( real_type, real_type, real_type ) {}
     void            update_frozen( real_type, real_type ) {}
     void            match_shape() {}
-    void            restore_shape( real_type, real_type, int ) {}
+    void            restore_shape( real_type, real_type, int, int ) {}
     void            update_display_matrix() {}
     void            update_boundingbox() {}
     vector_type     get_initial_center() { return math< Traits >::vector_zero(); }
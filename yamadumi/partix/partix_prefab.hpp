@@ -0,0 +1,297 @@
+/*!
+  @file		partix_prefab.hpp
+  @brief	<Tv>
+
+  SoftVolume̐ev[gƍėpv[
+*/
+#ifndef PARTIX_PREFAB_HPP
+#define PARTIX_PREFAB_HPP
+
+#include "partix_softvolume.hpp"
+#include "partix_tetrahedral_mesh.hpp"
+#include "partix_lod.hpp"
+#include <map>
+#include <string>
+
+namespace partix {
+
+// Prefab
+//	 setupς݂TetrahedralMeshev[gƂĎA
+//	 SoftVolume𕥂oBԋpꂽSoftVolume̓bVƍėp̂
+//	 ( <= ߋ̍ő哯)ł̓q[v蓖ĂNȂB
+//	 ebVo^ƁACX^XƂɍ/e؂ւ(LOD)B
+
+template < class Traits >
+class Prefab {
+public:
+	typedef TetrahedralMesh< Traits >			mesh_type;
+	typedef SoftVolume< Traits >				softvolume_type;
+	typedef std::vector< softvolume_type* >		softvolumes_type;
+	typedef typename Traits::real_type			real_type;
+	typedef typename Traits::vector_type		vector_type;
+	typedef TetrahedralEmbedding< Traits >		embedding_type;
+	typedef LodSelector< Traits >				lod_selector_type;
+
+	enum {
+		LEVEL_FINE		= 0,
+		LEVEL_COARSE	= 1,
+	};
+
+public:
+	// LPrefabɈړ
+	Prefab( mesh_type* m ) : template_( m ), coarse_template_( NULL ) {}
+	~Prefab()
+	{
+		for( typename softvolumes_type::const_iterator i =
+				 instances_.begin() ;
+			 i != instances_.end() ;
+			 ++i ) {
+			typename lods_type::iterator j = lods_.find( *i );
+			if( j == lods_.end() ) {
+				mesh_type* m = (*i)->get_mesh();
+				delete *i;
+				delete m;
+			} else {
+				delete *i;
+				delete (*j).second.fine;
+				delete (*j).second.coarse;
+			}
+		}
+		delete template_;
+		delete coarse_template_;
+	}
+
+	// ebV(templateƓʒűԂɒu)o^
+	// LPrefabɈړBCX^XOɌĂԂ
+	void set_coarse_template( mesh_type* m )
+	{
+		assert( instances_.empty() );
+		delete coarse_template_;
+		coarse_template_ = m;
+		fine_in_coarse_.build( coarse_template_, template_ );
+		coarse_in_fine_.build( template_, coarse_template_ );
+	}
+
+	mesh_type* get_coarse_template() { return coarse_template_; }
+
+	softvolume_type* spawn()
+	{
+		softvolume_type* v;
+		if( free_.empty() ) {
+			v = create();
+		} else {
+			v = free_.back();
+			free_.pop_back();
+			if( coarse_template_ ) {
+				lod_entry_type& e = lods_[v];
+				if( e.level != LEVEL_FINE ) {
+					v->set_mesh( e.fine );
+					e.level = LEVEL_FINE;
+				}
+			}
+			// vectoȓȂ̂œ傫ȂĊ蓖Ă͋NȂ
+			v->get_mesh()->get_points() = template_->get_points();
+		}
+		v->reset();
+		if( coarse_template_ ) { lods_[v].active = true; }
+		return v;
+	}
+
+	// World͂炩remove_bodyĂ
+	void despawn( softvolume_type* v )
+	{
+		if( coarse_template_ ) { lods_[v].active = false; }
+		free_.push_back( v );
+	}
+
+	int get_level( softvolume_type* v )
+	{
+		typename lods_type::const_iterator i = lods_.find( v );
+		if( i == lods_.end() ) { return LEVEL_FINE; }
+		return (*i).second.level;
+	}
+
+	// /e؂ւ
+	//	 WorldɓĂ΁AWorld::set_body_meshœꂽ܂܍ւ
+	//	 (ڐGLbV͂bodŷ̕ĂAislandNȂ)
+	template < class World >
+	void set_level( softvolume_type* v, int level, World* world )
+	{
+		assert( coarse_template_ );
+		typename lods_type::iterator i = lods_.find( v );
+		assert( i != lods_.end() );
+		lod_entry_type& e = (*i).second;
+		if( e.level == level ) { return; }
+
+		bool in_world = 0 <= v->get_slot() || 0 <= v->get_island();
+
+		if( level == LEVEL_COARSE ) {
+			// ʒu͌`󍇂킹̕ϊŁAÖړ͏dS̈ړ + `ϊ
+			// Ă͂߂̂Ŏʂ(+`ό`Ȃ猵)B
+			// ׂ_̑xetetrahedronŊO}
+			// ΂̂ŎgȂ
+			v->regularize();
+			real_type M[9];
+			vector_type dc;
+			v->fit_linear_displacement( M, dc );
+			coarse_in_fine_.transfer( e.fine, e.coarse );
+			typename mesh_type::points_type& points =
+				e.coarse->get_points();
+			for( typename mesh_type::points_type::iterator j =
+					 points.begin() ;
+				 j != points.end() ;
+				 ++j ) {
+				typename mesh_type::point_type& p = *j;
+				p.new_position = v->get_current_position( p.source_position );
+				p.old_position = p.new_position -
+					v->get_linear_displacement( M, dc, p.source_position );
+			}
+			set_mesh( v, e.coarse, in_world ? world : NULL );
+		} else {
+			fine_in_coarse_.transfer( e.coarse, e.fine );
+			set_mesh( v, e.fine, in_world ? world : NULL );
+		}
+		e.level = level;
+	}
+
+	// spawñCX^Xselector̔ɏ]Đ؂ւ
+	template < class World >
+	void update_lod( lod_selector_type& selector, World* world )
+	{
+		if( !coarse_template_ ) { return; }
+		for( typename lods_type::iterator i = lods_.begin() ;
+			 i != lods_.end() ;
+			 ++i ) {
+			lod_entry_type& e = (*i).second;
+			if( !e.active ) { continue; }
+			int level = selector.select( (*i).first, e.level );
+			if( level != e.level ) {
+				set_level( (*i).first, level, world );
+			}
+		}
+	}
+
+	// n̂܂Ŋ蓖ĂȂspawnł悤ɂ
+	void reserve( int n )
+	{
+		while( int( instances_.size() ) < n ) {
+			free_.push_back( create() );
+		}
+	}
+
+	mesh_type*	get_template() { return template_; }
+	int			get_instance_count() { return int( instances_.size() ); }
+	int			get_free_count() { return int( free_.size() ); }
+
+private:
+	template < class World >
+	static void set_mesh( softvolume_type* v, mesh_type* m, World* world )
+	{
+		if( world ) {
+			world->set_body_mesh( v, m );
+		} else {
+			v->set_mesh( m );
+			v->regularize();
+		}
+	}
+
+	Prefab( const Prefab& ){}
+	void operator=( const Prefab& ){}
+
+	softvolume_type* create()
+	{
+		softvolume_type* v = new softvolume_type;
+		v->set_mesh( template_->clone() );
+		instances_.push_back( v );
+		if( coarse_template_ ) {
+			lod_entry_type& e = lods_[v];
+			e.fine = v->get_mesh();
+			e.coarse = coarse_template_->clone();
+			e.level = LEVEL_FINE;
+			e.active = false;
+		}
+
+		// despawnŊ蓖ĂNȂ悤
+		free_.reserve( instances_.capacity() );
+		return v;
+	}
+
+private:
+	struct lod_entry_type {
+		mesh_type*	fine;
+		mesh_type*	coarse;
+		int			level;
+		bool		active;
+	};
+	typedef std::map< softvolume_type*, lod_entry_type > lods_type;
+
+private:
+	mesh_type*			template_;
+	softvolumes_type	instances_;
+	softvolumes_type	free_;
+
+	// LOD
+	mesh_type*			coarse_template_;
+	embedding_type		fine_in_coarse_;	// ׂ̓_e̎lʑ̂
+	embedding_type		coarse_in_fine_;	// e̓_ׂ̎lʑ̂
+	lods_type			lods_;
+
+};
+
+// PrefabRegistry
+//	 O(bVt@CȂ)L[PrefabǗ
+
+template < class Traits >
+class PrefabRegistry {
+public:
+	typedef Prefab< Traits >						prefab_type;
+	typedef typename prefab_type::mesh_type			mesh_type;
+	typedef typename prefab_type::softvolume_type	softvolume_type;
+	typedef std::map< std::string, prefab_type* >	prefabs_type;
+
+public:
+	PrefabRegistry() {}
+	~PrefabRegistry()
+	{
+		for( typename prefabs_type::const_iterator i = prefabs_.begin() ;
+			 i != prefabs_.end() ;
+			 ++i ) {
+			delete (*i).second;
+		}
+	}
+
+	// LPrefabRegistryɈړ
+	prefab_type* add( const std::string& name, mesh_type* m )
+	{
+		assert( prefabs_.find( name ) == prefabs_.end() );
+		prefab_type* p = new prefab_type( m );
+		prefabs_[name] = p;
+		return p;
+	}
+
+	prefab_type* find( const std::string& name )
+	{
+		typename prefabs_type::const_iterator i = prefabs_.find( name );
+		if( i == prefabs_.end() ) { return NULL; }
+		return (*i).second;
+	}
+
+	softvolume_type* spawn( const std::string& name )
+	{
+		prefab_type* p = find( name );
+		if( !p ) { return NULL; }
+		return p->spawn();
+	}
+
+private:
+	PrefabRegistry( const PrefabRegistry& ){}
+	void operator=( const PrefabRegistry& ){}
+
+private:
+	prefabs_type	prefabs_;
+
+};
+
+} // namespace partix
+
+#endif // PARTIX_PREFAB_HPP
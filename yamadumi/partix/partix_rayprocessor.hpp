@@ -31,9 +31,7 @@ public:
     typedef typename std::vector< cloud_type* >     clouds_type;
     typedef typename std::vector< collidable_type* > collidables_type;
     typedef typename cloud_type::points_type        points_type;
-        
-    typedef std::set< cloud_type* >                 cloud_set;
-    typedef std::set< collidable_type* >            collidable_set;
+    typedef typename collidable_type::normals_type  normals_type;
 
     struct triangle_slot {
         int                     body_id;
@@ -48,13 +46,18 @@ public:
         int                     body_id;
         collidable_type*        collidable;
         vector_type             source;
+        vector_type             end;     // ʏtarget->new_position
         point_type*             target;
         int                     index;
         vector_type             uvt;
         triangle_slot           nearest; // |C^ɂĂ͂
                                          // (Ă܂)
+        ray_slot*               swept;   // ǉswept ray(ȂNULL)
     };
 
+    typedef RayTriangleSpatialHash< Traits, ray_slot*, triangle_slot >
+        rtsh_type;
+
     struct ray_triangle_spatial_hash_applier {
         void operator()(
             ray_slot* r,
@@ -63,6 +66,18 @@ public:
         {
             real_type z = vector_traits::z( uvt );
             if( z < vector_traits::z( r->uvt ) ) {
+                if( !r->collidable->get_body()->test_collision_filter(
+                        t.collidable->get_body() ) ) {
+                    return;
+                }
+                // volumemrayŉȂ
+                // (swept raycenter̊O痈̂ővolumeɂ)
+                if( dynamic_cast< Volume< Traits >* >(
+                        r->collidable->get_body() ) &&
+                    dynamic_cast< Volume< Traits >* >(
+                        t.collidable->get_body() ) ) {
+                    return;
+                }
                 r->uvt = uvt;
                 r->nearest = t;
             }
@@ -70,10 +85,28 @@ public:
     };
 
 public:
-    RayProcessor( real_type gridsize, int hashsize )
-        : pool_( page_provider_, "rayproc" ), rtsh_( gridsize, hashsize ) {}
+    RayProcessor(
+        real_type   gridsize,
+        int         hashsize,
+        page_arena& arena = page_arena::instance() )
+        : page_provider_( arena ),
+          pool_( page_provider_, "rayproc" ),
+          rtsh_( gridsize, hashsize, arena )
+    {
+        epoch_ = 0;
+        swept_ = false;
+    }
     ~RayProcessor(){}
 
+    // swept mode
+    //   1Xebvrecommended grid size̔ȏ㓮_́A
+    //   dSrayɉāAold_position玟̃Xebv̗\ʒu
+    //   (new_position + ړ)܂łrayׂB
+    //   ̂蔲_ƁÃXebvł蔲ȓ_B
+    //   dSrayĂ΂D悷
+    void set_swept( bool f ) { swept_ = f; }
+    bool get_swept() { return swept_; }
+
     template < class F >
     void apply( F reflect, const collidables_type& B2 )
     {
@@ -81,12 +114,16 @@ public:
 
         pool_.clear();
 
+        // R, T̏dp(񑝂₷)
+        if( ++epoch_ == 0 ) { ++epoch_; }
+
         typedef typename collidables_type::const_iterator collidables_iterator;
 
         pc.print( "rp0" );
         
         // volumeƂڐGĂȂvolume菜
-        collidables_type B;
+        collidables_type& B = B_;
+        B.clear();
         for( collidables_iterator i = B2.begin() ;
              i != B2.end() ;
              ++i ) {
@@ -119,8 +156,10 @@ public:
         pc.print( "rp1" );
         // RayWATriangleW̍쐬
         float grid_size = 0;
-        collidable_set R;
-        collidable_set T;
+        collidables_type& R = R_;
+        collidables_type& T = T_;
+        R.clear();
+        T.clear();
         for( collidables_iterator i = B.begin() ;
              i != B.end() ;
              ++i ) {
@@ -132,34 +171,33 @@ public:
             //  ( frozenȂ͕̂ʂɂ )
             if( !c->get_body()->get_positive() ) { continue; }
 
-            R.insert( c );
+            if( c->mark_ray( epoch_ ) ) { R.push_back( c ); }
 
             // UIuWFNgQƂĂIuWFNĝ
             // TriangleƂĎgp
-            T.insert( c->get_neighbors().begin(),
-                      c->get_neighbors().end() );
+            collidables_type& neighbors = c->get_neighbors();
+            for( collidables_iterator j = neighbors.begin() ;
+                 j != neighbors.end() ;
+                 ++j ) {
+                if( (*j)->mark_triangle( epoch_ ) ) { T.push_back( *j ); }
+            }
         }
 
         pc.print( "rp2" );
-        // CloudW̍쐬
-        cloud_set C;
-        for( typename collidable_set::const_iterator i = R.begin() ;
+        // raytest̏
+        //   ȍ~RoRł_GȂ̂ŁARoRŖ߂Α
+        for( collidables_iterator i = R.begin() ;
              i != R.end() ;
              ++i ) {
-            C.insert( (*i)->get_cloud() );
-        }
-
-        for( typename cloud_set::const_iterator i = C.begin() ;
-             i != C.end() ;
-             ++i ) {
-            cloud_type* c = *i;
+            collidable_type* collidable = *i;
+            indices_type&   indices   = collidable->get_indices(); 
+            points_type&    points    = collidable->get_cloud()->get_points();
 
-            points_type& points = c->get_points();
-            for( typename points_type::iterator j = points.begin() ;
-                 j != points.end() ;
-                 ++j ) {
-                point_type& p = *j;
-                p.raytest     = 0;
+            for( typename indices_type::const_iterator k =
+                     indices.begin() ;
+                 k != indices.end() ;
+                 ++k ) {
+                points[*k].raytest = 0;
             }
         }
 
@@ -169,7 +207,13 @@ public:
 
         pc.print( "rp4" );
         // rayspatial hashɒǉ
-        for( typename collidable_set::const_iterator j = R.begin() ;
+        //   RAY_PACKET_SIZE{܂Ƃ߂DDAH
+        const int packet_size = rtsh_type::RAY_PACKET_SIZE;
+        vector_type packet_s0[packet_size];
+        vector_type packet_s1[packet_size];
+        ray_slot*   packet_load[packet_size];
+        int         packet_count = 0;
+        for( collidables_iterator j = R.begin() ;
              j != R.end() ;
              ++j ) {
             collidable_type* collidable = *j;
@@ -181,6 +225,10 @@ public:
             indices_type&   indices   = collidable->get_indices(); 
             points_type&    points    = cloud->get_points();
 
+            real_type swept_length =
+                collidable->get_recommended_grid_size() * 0.5f;
+            real_type swept_threshold = swept_length * swept_length;
+
             for( typename indices_type::const_iterator k =
                      indices.begin() ;
                  k != indices.end() ;
@@ -198,18 +246,37 @@ public:
                 ri->body_id     = body_id;
                 ri->collidable  = collidable;
                 ri->source      = collidable->get_center();
+                ri->end         = point.new_position;
                 ri->target      = &point;
                 ri->index       = int( i0 );
                 ri->uvt         = math< Traits >::vector_max();
-                rtsh_.add_ray( ri->source, ri->target->new_position, ri );
+                ri->swept       = NULL;
                 point.ray_slot = ri;
+                add_ray( ri, packet_s0, packet_s1, packet_load, packet_count );
+
+                if( swept_ ) {
+                    vector_type d = point.new_position - point.old_position;
+                    if( swept_threshold < math< Traits >::length_sq( d ) ) {
+                        ray_slot* si = (ray_slot*)pool_.allocate();
+                        *si = *ri;
+                        si->source = point.old_position;
+                        si->end    = point.new_position + d;
+                        ri->swept  = si;
+                        add_ray(
+                            si,
+                            packet_s0, packet_s1, packet_load, packet_count );
+                    }
+                }
             }
         }
+        if( 0 < packet_count ) {
+            rtsh_.add_rays( packet_s0, packet_s1, packet_load, packet_count );
+        }
 
         // RayVolume
         // TriangleVolume͍폜Ă
         bool remove_volume = true;
-        for( typename collidable_set::const_iterator i = R.begin() ;
+        for( collidables_iterator i = R.begin() ;
              i != R.end() ;
              ++i ) {
             if( !dynamic_cast< Volume< Traits >* >( (*i)->get_body() ) ) {
@@ -220,7 +287,7 @@ public:
 
         pc.print( "rp5" );
         // trianglespatial hashɒǉ
-        for( typename collidable_set::const_iterator i = T.begin() ;
+        for( collidables_iterator i = T.begin() ;
              i != T.end() ;
              ++i ) {
             if( remove_volume &&
@@ -237,9 +304,13 @@ public:
             faces_type&     faces     = collidable->get_faces(); 
             points_type&    points    = cloud->get_points();
 
+            // ʖ@stepƂ̃LbVg
+            const normals_type& normals = collidable->get_face_normals();
+
+            int face_index = 0;
             for( typename faces_type::const_iterator k = faces.begin() ;
                  k != faces.end() ;
-                 ++k ) {
+                 ++k, ++face_index ) {
                 const face_type& face = *k;
 
                 point_type& p0 = points[face.i0];
@@ -250,8 +321,7 @@ public:
                 vector_type& v1 = p1.new_position;
                 vector_type& v2 = p2.new_position;
 
-                vector_type n = math< Traits >::normalize(
-                    math< Traits >::cross( v1 - v0, v2 - v0 ) );
+                const vector_type& n = normals[face_index];
 
                 triangle_slot ti;
                 ti.body_id    = body_id;
@@ -268,7 +338,7 @@ public:
         rtsh_.apply( ray_triangle_spatial_hash_applier() );
 
         pc.print( "rp7" );
-        for( typename collidable_set::const_iterator j = R.begin() ;
+        for( collidables_iterator j = R.begin() ;
              j != R.end() ;
              ++j ) {
             collidable_type* collidable = *j;
@@ -293,15 +363,41 @@ public:
                 ray_slot* rs = (ray_slot*)point.ray_slot;
                 if( vector_traits::z( rs->uvt ) < 1.0f ) {
                     reflect( rs );
+                } else if( rs->swept &&
+                           vector_traits::z( rs->swept->uvt ) < 1.0f ) {
+                    reflect( rs->swept );
                 }
             }
         }
     }
 
 private:
-    default_page_provider                                   page_provider_;
-    fixed_pool< sizeof( ray_slot ), default_page_provider > pool_;
-    RayTriangleSpatialHash< Traits, ray_slot*, triangle_slot > rtsh_;
+    // RAY_PACKET_SIZE{܂spatial hashɒǉ
+    void add_ray(
+        ray_slot*       ri,
+        vector_type*    packet_s0,
+        vector_type*    packet_s1,
+        ray_slot**      packet_load,
+        int&            packet_count )
+    {
+        packet_s0[packet_count]   = ri->source;
+        packet_s1[packet_count]   = ri->end;
+        packet_load[packet_count] = ri;
+        if( ++packet_count == rtsh_type::RAY_PACKET_SIZE ) {
+            rtsh_.add_rays( packet_s0, packet_s1, packet_load, packet_count );
+            packet_count = 0;
+        }
+    }
+
+private:
+    arena_page_provider                                     page_provider_;
+    fixed_pool< sizeof( ray_slot ), arena_page_provider >   pool_;
+    unsigned int                                            epoch_;
+    bool                                                    swept_;
+    collidables_type                                        B_;
+    collidables_type                                        R_;
+    collidables_type                                        T_;
+    rtsh_type                                               rtsh_;
 
 };
 
@@ -57,6 +57,7 @@ public:
 			math< Traits >::vector_zero();
 		restore_factor_ = 1.0f;
 		stretch_factor_ = 0.0f;
+		shape_residual_ = 0;
 		math< Traits >::make_identity( R_ );
 		math< Traits >::make_identity( G_ );
 	}
@@ -73,6 +74,10 @@ public:
 	{
 		apply_snapshot_internal( ss );
 	}
+	void store_snapshot( BodySnapShot< Traits >* ss )
+	{
+		store_snapshot_internal( ss );
+	}
 
 	void regularize() { regularize_internal(); }
 	void list_collision_units( collidables_type& s )
@@ -92,9 +97,9 @@ public:
 	{
 		match_shape_internal();
 	}
-	void restore_shape( real_type dt, real_type idt, int kmax )
+	void restore_shape( real_type dt, real_type idt, int kmax, int passes )
 	{
-		restore_shape_internal( dt, idt, kmax );
+		restore_shape_internal( dt, idt, kmax, passes );
 	}
 	void end_frame()
 	{
@@ -129,6 +134,8 @@ public:
 	void set_restore_factor( real_type x ) { restore_factor_ = x; }
 	void set_stretch_factor( real_type x ) { stretch_factor_ = x; }
 
+	real_type get_shape_residual() { return shape_residual_; }
+
 private:
 	SoftShell( const SoftShell& ){}
 	void operator=( const SoftShell& ){}
@@ -139,17 +146,26 @@ private:
 		// LSnapShotɈړ
 		SoftShellSnapShot< Traits >* ds =
 			new SoftShellSnapShot< Traits >;
+		store_snapshot_internal( ds );
+		return ds;
+	}
 
+	void store_snapshot_internal( BodySnapShot< Traits >* ss )
+	{
+		SoftShellSnapShot< Traits >* ds =
+			dynamic_cast< SoftShellSnapShot< Traits >* >( ss );
+		assert( ds );
+
+		ds->clouds.resize( this->clouds_.size() );
+		int jj = 0;
 		for( typename clouds_type::iterator j =
 				 this->clouds_.begin() ;
 			 j != this->clouds_.end() ;
 			 ++j ) {
-			ds->clouds.push_back( **j );
+			ds->clouds[jj++] = **j;
 		}
 		ds->initial_center = initial_center_;
 		ds->global_force   = this->get_global_force();
-
-		return ds;
 	}
 
 	void apply_snapshot_internal( const BodySnapShot< Traits >* ss )
@@ -398,19 +414,24 @@ private:
 
 	}
 		
-	void restore_shape_internal( real_type dt, real_type idt, int kmax )
+	void restore_shape_internal(
+		real_type dt, real_type idt, int kmax, int passes )
 	{
+		shape_residual_ = 0;
+
 		if( touch_level_ == 0 ) {
 			if( !this->get_alive() ) { return ; }
 			if( this->get_frozen() ) { return; }
 		}
 				
+		// kmax+1ōvrestore_factor_߂passes
 		real_type rest =
 			real_type( 1.0 ) -
 			pow( real_type( 1.0 ) - restore_factor_,
-				 real_type( 1.0 ) / ( kmax + real_type ( 1.0 ) ) );
+				 real_type( passes ) / ( kmax + real_type ( 1.0 ) ) );
 				
 		// ̓Kp
+		real_type residual = 0;
 		for( typename clouds_type::const_iterator i =
 				 this->clouds_.begin() ;
 			 i != this->clouds_.end() ;
@@ -430,11 +451,15 @@ private:
 								
 				g += current_center_;
 
-				vector_type velocity_dt =
-					( g - point.new_position ) * rest;
+				vector_type d = g - point.new_position;
+				real_type dd = math< Traits >::length_sq( d );
+				if( residual < dd ) { residual = dd; }
+
+				vector_type velocity_dt = d * rest;
 				point.new_position += velocity_dt;
 			}
 		}
+		shape_residual_ = real_type( sqrt( residual ) );
 
 	}
 
@@ -500,6 +525,14 @@ private:
 	void end_frame_internal()
 	{
 		touch_level_ = 0;
+
+		// ʖ@͂̃Xebv̍ŏIʒuō蒼
+		for( typename blocks_type::const_iterator i =
+				 this->blocks_.begin() ;
+			 i != this->blocks_.end() ;
+			 ++i ) {
+			(*i)->invalidate_face_normals();
+		}
 	}
 
 	void move_internal( const vector_type& v )
@@ -722,6 +755,7 @@ private:
 	real_type		restore_factor_;
 	real_type		stretch_factor_;
 	real_type		freezing_duration_;
+	real_type		shape_residual_;
 
 	template < class T > friend class World;
 };
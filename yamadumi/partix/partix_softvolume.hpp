@@ -13,6 +13,13 @@
 #include "partix_collidable.hpp"
 #include "partix_spatial_hash.hpp"
 #include <string>
+#include <vector>
+
+// match_shapeRA̍s񎮂1痣ꂷbodycrushedɂ
+//	 (ł͖BPNX^łNX^łg)
+#ifndef PARTIX_SOFTVOLUME_CRUSH_TEST
+#define PARTIX_SOFTVOLUME_CRUSH_TEST 0
+#endif
 
 namespace partix {
 
@@ -20,6 +27,7 @@ namespace partix {
 template < class Traits >
 class SoftVolumeSnapShot : public BodySnapShot< Traits > {
 public:
+	typedef typename Traits::real_type		real_type;
 	typedef typename Traits::vector_type	vector_type;
 	typedef typename Traits::matrix_type	matrix_type;
 
@@ -31,6 +39,36 @@ public:
 	Cloud< Traits > cloud;
 	vector_type		initial_center;
 	vector_type		global_force;
+
+	// ȉWorld̊߂(adaptive timestep)p
+	vector_type		current_center;
+	vector_type		bbmin;
+	vector_type		bbmax;
+	real_type		R[9];
+	real_type		G[9];
+	real_type		display_G[9];
+	vector_type		display_t;
+	matrix_type		deformed_matrix;
+	matrix_type		orientation_matrix;
+	real_type		freezing_duration;
+	real_type		crush_duration;
+	real_type		dump;
+	int				touch_level;
+	bool			frozen;
+	bool			defrosting;
+
+	// ̋ߎ
+	bool			rigid;
+	real_type		rigid_duration;
+	real_type		rigid_mass;
+	vector_type		rigid_offset;
+	real_type		rigid_S[9];
+	real_type		rigid_inverse_inertia[9];
+	vector_type		rigid_velocity;
+	vector_type		rigid_angular_momentum;
+
+	// NX^̑Ỏ]
+	std::vector< real_type > cluster_rotations;
 };
 
 template < class Traits >
@@ -66,10 +104,26 @@ public:
 		stretch_factor_ = 0;
 		freezing_duration_ = 0;
 		crush_duration_ = 0;
+		crushed_ = false;
+		distortion_ = 0;
+		shape_residual_ = 0;
+		shape_restored_ = false;
+		rigid_proxy_enabled_ = false;
+		rigid_enter_residual_ = 0;
+		rigid_enter_duration_ = 0;
+		rigid_exit_velocity_ = 0;
+		rigid_ = false;
+		rigid_duration_ = 0;
+		cluster_divisions_ = 0;
+		cluster_width_ = 0;
+		cluster_whole_rest_[CLUSTER_REST_VALID] = 0;
 		debug_flag_ = false;
 		math< Traits >::make_identity( criterion_ );
 		math< Traits >::make_identity( R_ );
 		math< Traits >::make_identity( G_ );
+		math< Traits >::make_identity( display_G_ );
+		math< Traits >::make_identity( previous_display_G_ );
+		display_t_ = previous_display_t_ = math< Traits >::vector_zero();
 	}
 	~SoftVolume(){}
 
@@ -84,12 +138,17 @@ public:
 	{
 		apply_snapshot_internal( ss );
 	}
+	void store_snapshot( BodySnapShot< Traits >* ss )
+	{
+		store_snapshot_internal( ss );
+	}
 
 	void regularize()
 	{
 		regularize_internal();
 		match_shape_internal();
 		update_display_matrix_internal();
+		store_display_state();
 	}
 	void list_collision_units( collidables_type& s )
 	{
@@ -108,6 +167,15 @@ public:
 	void set_name( const char* p ) { name_ = p; }
 		
 	bool crushed() { return crushed_; }
+
+	// Omatch_shapełAR̍s񎮂1̂(傫قǉĂ)
+	real_type get_distortion()
+	{
+		if( crushed_ ) { return math< Traits >::real_max(); }
+		return distortion_;
+	}
+
+	real_type get_shape_residual() { return shape_residual_; }
 		
 	vector_type get_initial_center() { return initial_center_; }
 		
@@ -140,16 +208,69 @@ public:
 		rotate_teleportal_internal( w, x, y, z, pivot );
 	}
 	void kill_inertia() { kill_inertia_internal(); }
+	void reset() { reset_internal(); }
 	void reset_rotation() { reset_rotation_internal(); }
 
 	const matrix_type& get_deformed_matrix() { return deformed_matrix_; }
 	const matrix_type& get_orientation_matrix() { return orientation_matrix_; }
 
+	// ÕXebvJn(alpha=0)ƌ(alpha=1)̊ԂԂ
+	// deformed_matrix(World::get_interpolation_alpha()Ƒgݍ킹Ďg)
+	matrix_type get_interpolated_deformed_matrix( real_type alpha )
+	{
+		real_type G[9];
+		for( int i = 0 ; i < 9 ; i++ ) {
+			G[i] = previous_display_G_[i] +
+				( display_G_[i] - previous_display_G_[i] ) * alpha;
+		}
+		vector_type t = previous_display_t_ +
+			( display_t_ - previous_display_t_ ) * alpha;
+
+		matrix_type m;
+		Traits::make_matrix( m, G, t );
+		return m;
+	}
+
 	void update_mass() { update_mass_internal(); }
 
 	void set_restore_factor( real_type x ) { restore_factor_ = x; }
 	void set_stretch_factor( real_type x ) { stretch_factor_ = x; }
 
+	// ̋ߎ
+	//	 XebvI̖ڕWʒûꂪenter_residual̏Ԃ
+	//	 enter_durationbAdSƉ]œ
+	//	 _͂疈Xebv蒼(`󍇂킹ȗ)B
+	//	 ڐGɂ_̑xωexit_velocity𒴂_̂ɖ߂
+	void set_rigid_proxy(
+		bool		enable,
+		real_type	enter_residual,
+		real_type	enter_duration,
+		real_type	exit_velocity )
+	{
+		rigid_proxy_enabled_ = enable;
+		rigid_enter_residual_ = enter_residual;
+		rigid_enter_duration_ = enter_duration;
+		rigid_exit_velocity_ = exit_velocity;
+		if( !enable ) { leave_rigid(); }
+	}
+	bool get_rigid() { return rigid_; }
+
+	// NX^ɂ`󍇂킹
+	//	 `ŒӂdivisionsɂȂiqɐ؂A_܂ރZƂ
+	//	 Owidth̃Z͈̔͂NX^ƂČ`󍇂킹āA
+	//	 _̖ڕWʒu͂̓_܂ރNX^̕ςɂB
+	//	 ZƂ̘aƂ̗ݐϘaŔ͈͂ɍL̂ŁA
+	//	 _̎ԂwidthɂȂBdivisions = 0őS1(]ǂ)
+	void set_clusters( int divisions, int width )
+	{
+		assert( 0 <= divisions && 0 <= width );
+		cluster_divisions_ = divisions;
+		cluster_width_ = width;
+		set_touch_level( 2 );
+	}
+	int get_cluster_divisions() { return cluster_divisions_; }
+	int get_cluster_width() { return cluster_width_; }
+
 	vector_type get_current_origin()
 	{
 		return transform( -initial_center_ );
@@ -158,6 +279,30 @@ public:
 	{
 		return current_center_;
 	}
+	// ʒusource̓_̕ό`(Omatch_shape)łǂɂ邩
+	vector_type get_current_position( const vector_type& source )
+	{
+		return transform( source - initial_center_ );
+	}
+
+	// ÕXebv̓_̈ړ(new_position - old_position)
+	// dS̈ړdcƏ`󂩂̐`ϊMɓĂ͂߂
+	//	 M͌`󍇂킹ƓAqqŋ߂B_Ƃ̂΂܂܂Ȃ̂ŁA
+	//	 LOD̐؂ւŕʂ̃bVɑxʂƂɎg
+	void fit_linear_displacement( real_type* M, vector_type& dc )
+	{
+		fit_linear_displacement_internal( M, dc );
+	}
+	vector_type get_linear_displacement(
+		const real_type* M, const vector_type& dc, const vector_type& source )
+	{
+		vector_type q;
+		math< Traits >::transform_vector(
+			q, criterion_, source - initial_center_ );
+		vector_type d;
+		math< Traits >::transform_vector( d, M, q );
+		return dc + d;
+	}
 
 private:
 	SoftVolume( const SoftVolume& ){}
@@ -176,9 +321,9 @@ private:
 	{
 		match_shape_internal();
 	}
-	void restore_shape( real_type dt, real_type idt, int kmax )
+	void restore_shape( real_type dt, real_type idt, int kmax, int passes )
 	{
-		restore_shape_internal( dt, idt, kmax );
+		restore_shape_internal( dt, idt, kmax, passes );
 	}
 	void update_display_matrix()
 	{
@@ -231,7 +376,7 @@ private:
 		set_criterial_matrix_internal( m );
 	}
 
-	void mark_border_edges( EdgeFaceSpatialHash< Traits >& hash )
+	void mark_border_edges( VolumeFaceSpatialHash< Traits >& hash )
 	{
 		mark_border_edges_internal( hash );
 	}
@@ -278,19 +423,94 @@ private:
 	{
 		// LSnapShotɈړ
 
-		// TODO: 
 		SoftVolumeSnapShot< Traits >* ds =
 			new SoftVolumeSnapShot< Traits >;
+		store_snapshot_internal( ds );
 		return ds;
 	}
 
+	void store_snapshot_internal( BodySnapShot< Traits >* ss )
+	{
+		SoftVolumeSnapShot< Traits >* ds =
+			dynamic_cast< SoftVolumeSnapShot< Traits >* >( ss );
+		assert( ds );
+
+		// 傫vectoȓȂ̂ōĊ蓖Ă͋NȂ
+		ds->cloud				= *this->get_mesh()->get_cloud();
+		ds->initial_center		= initial_center_;
+		ds->global_force		= this->get_global_force();
+		ds->current_center		= current_center_;
+		ds->bbmin				= bbmin_;
+		ds->bbmax				= bbmax_;
+		math< Traits >::copy_matrix( ds->R, R_ );
+		math< Traits >::copy_matrix( ds->G, G_ );
+		math< Traits >::copy_matrix( ds->display_G, display_G_ );
+		ds->display_t			= display_t_;
+		ds->deformed_matrix		= deformed_matrix_;
+		ds->orientation_matrix	= orientation_matrix_;
+		ds->freezing_duration	= freezing_duration_;
+		ds->crush_duration		= crush_duration_;
+		ds->dump				= this->get_internal_dump_factor();
+		ds->touch_level			= touch_level_;
+		ds->frozen				= this->get_frozen();
+		ds->defrosting			= this->get_defrosting();
+
+		ds->rigid				= rigid_;
+		ds->rigid_duration		= rigid_duration_;
+		ds->rigid_mass			= rigid_mass_;
+		ds->rigid_offset		= rigid_offset_;
+		math< Traits >::copy_matrix( ds->rigid_S, rigid_S_ );
+		math< Traits >::copy_matrix(
+			ds->rigid_inverse_inertia, rigid_inverse_inertia_ );
+		ds->rigid_velocity		= rigid_velocity_;
+		ds->rigid_angular_momentum = rigid_angular_momentum_;
+
+		ds->cluster_rotations	= cluster_rotations_;
+	}
+
 	void apply_snapshot_internal( const BodySnapShot< Traits >* ss )
 	{
-		// TODO: 
-		const SoftShellSnapShot< Traits >* ds =
-			dynamic_cast< const SoftShellSnapShot< Traits >* >(
+		const SoftVolumeSnapShot< Traits >* ds =
+			dynamic_cast< const SoftVolumeSnapShot< Traits >* >(
 				ss );
 		assert( ds );
+
+		// 傫vectoȓȂ̂ōĊ蓖Ă͋NȂ
+		*this->get_mesh()->get_cloud() = ds->cloud;
+		initial_center_		= ds->initial_center;
+		this->set_global_force( ds->global_force );
+		current_center_		= ds->current_center;
+		bbmin_				= ds->bbmin;
+		bbmax_				= ds->bbmax;
+		math< Traits >::copy_matrix( R_, ds->R );
+		math< Traits >::copy_matrix( G_, ds->G );
+		math< Traits >::copy_matrix( display_G_, ds->display_G );
+		display_t_			= ds->display_t;
+		deformed_matrix_	= ds->deformed_matrix;
+		orientation_matrix_ = ds->orientation_matrix;
+		freezing_duration_	= ds->freezing_duration;
+		crush_duration_		= ds->crush_duration;
+		this->set_internal_dump_factor( ds->dump );
+		touch_level_		= ds->touch_level;
+		this->set_frozen( ds->frozen );
+		this->set_defrosting( ds->defrosting );
+		crushed_			= false;
+		distortion_			= 0;
+
+		rigid_				= ds->rigid && rigid_proxy_enabled_;
+		rigid_duration_		= ds->rigid_duration;
+		rigid_mass_			= ds->rigid_mass;
+		rigid_offset_		= ds->rigid_offset;
+		math< Traits >::copy_matrix( rigid_S_, ds->rigid_S );
+		math< Traits >::copy_matrix(
+			rigid_inverse_inertia_, ds->rigid_inverse_inertia );
+		rigid_velocity_		= ds->rigid_velocity;
+		rigid_angular_momentum_ = ds->rigid_angular_momentum;
+
+		// set_clustersō蒼Ă珉l̂܂
+		if( ds->cluster_rotations.size() == cluster_rotations_.size() ) {
+			cluster_rotations_ = ds->cluster_rotations;
+		}
 	}
 
 	void list_collision_units_internal( collidables_type& s )
@@ -300,10 +520,19 @@ private:
 
 	void begin_frame_internal()
 	{
+		// ԗpɃXebvJn̕\ԂoĂ
+		// (frozenȂǂupdate_display_matrixȗĂ낪)
+		store_display_state();
+
+		// O_𓮂ꂽ獄̂̏Ԃ͎gȂ
+		if( touch_level_ != 0 ) { leave_rigid(); }
+
 		if( touch_level_ == 2 ) {
 			regularize_internal();
 		}
 		crushed_ = false;
+		distortion_ = 0;
+		shape_restored_ = false;
 	}
 
 	void compute_motion_internal( real_type pdt, real_type dt, real_type idt )
@@ -321,6 +550,12 @@ private:
 		// dumping (adhoc, Î~ɗp)
 		real_type dump_factor =
 			pow(  real_type( 1.0 ) - this->get_internal_dump_factor(), dt );
+
+		if( rigid_ &&
+			compute_rigid_motion(
+				dt, idt, drag_coefficient, dump_factor ) ) {
+			return;
+		}
 #if 0
 		{
 			char buffer[256];
@@ -346,6 +581,11 @@ private:
 			if( !this->get_alive() ) { return; }
 			if( this->get_frozen() && !this->get_defrosting() ) { return; }
 		}
+		if( rigid_ ) { return; }
+		if( clustered_internal() ) {
+			match_clusters();
+			return;
+		}
 
 		// dSvZ
 		calculate_center();
@@ -408,7 +648,7 @@ private:
 		math< Traits >::multiply_matrix(
 			R, Apq, inverse_sqrt_ApqT_Apq );
 		
-#if 0
+#if PARTIX_SOFTVOLUME_CRUSH_TEST
 		real_type detR = math< Traits >::determinant_matrix( R );
 		if( 0.7f < std::abs( 1.0f - detR ) ) {
 			// Rꂷ
@@ -515,6 +755,13 @@ private:
 		real_type cbrt = pow(
 			std::abs( detA ), real_type( 1.0/3.0 ) );
 
+		// World::set_adaptive_timestep̔p
+		real_type detR = math< Traits >::determinant_matrix( R );
+		distortion_ = std::abs( real_type( 1.0 ) - detA );
+		if( distortion_ < std::abs( real_type( 1.0 ) - detR ) ) {
+			distortion_ = std::abs( real_type( 1.0 ) - detR );
+		}
+
 		real_type Adash[9];
 		math< Traits >::multiply_matrix(
 			Adash, A, real_type( 1.0 ) / cbrt );
@@ -537,62 +784,89 @@ private:
 
 	}
 
-	void restore_shape_internal( real_type dt, real_type idt, int kmax )
+	void restore_shape_internal(
+		real_type dt, real_type idt, int kmax, int passes )
 	{
+		shape_residual_ = 0;
+
 		if( touch_level_ == 0 ) {
 			if( !this->get_alive() ) { return; }
 			if( this->get_frozen() && !this->get_defrosting() ) { return; }
 		}
+		if( rigid_ ) { return; }
+
+		// World::set_shape_iterationsł1Xebvɉ񂩌Ă΂̂ŁA
+		// crusȟoߎԂfree_position̓Xebv̍ŏ̉񂾂
+		const bool first_pass = !shape_restored_;
+		shape_restored_ = true;
 
 		points_type& points = this->get_mesh()->get_points();
 
-		if( crushed_ ) {
-			// TODO:
-			if( crush_duration_ == 0 ) {
-				for( typename points_type::iterator i =
-						 points.begin() ;
-					 i != points.end() ;
-					 ++i ) {
-					point_type& p = *i;
-					p.new_position = p.old_position;
-					p.old_position += p.velocity * dt;
-					p.velocity *= -1;
+		if( first_pass ) {
+			if( crushed_ ) {
+				// TODO:
+				if( crush_duration_ == 0 ) {
+					for( typename points_type::iterator i =
+							 points.begin() ;
+						 i != points.end() ;
+						 ++i ) {
+						point_type& p = *i;
+						p.new_position = p.old_position;
+						p.old_position += p.velocity * dt;
+						p.velocity *= -1;
+					}
 				}
+				crush_duration_ += dt;
+				if( 0.03f <= crush_duration_ ) {
+					kill_inertia_internal();
+				}
+			} else {
+				crush_duration_ = 0;
 			}
-			crush_duration_ += dt;
-			if( 0.03f <= crush_duration_ ) {
-				kill_inertia_internal();
-			}
-		} else {
-			crush_duration_ = 0;
 		}
 				
+		// kmax+1ōvrestore_factor_߂passes
 		real_type rest =
 			real_type( 1.0 ) -
 			pow( real_type( 1.0 ) - restore_factor_,
-				 real_type( 1.0 ) / ( kmax + real_type ( 1.0 ) ) );
+				 real_type( passes ) / ( kmax + real_type ( 1.0 ) ) );
 				
+		const bool clustered = clustered_internal();
+		real_type residual = 0;
+		int ii = 0;
 		for( typename points_type::iterator i = points.begin() ;
 			 i != points.end() ;
-			 ++i ) {
+			 ++i, ++ii ) {
 			point_type& p = *i;
 
 			const vector_type& q = p.ideal_offset;
 								
 			vector_type g;
-			math< Traits >::transform_vector( g, G_, q );
+			if( !clustered ||
+				!cluster_goal( g, cluster_point_cells_[ii], q ) ) {
+				math< Traits >::transform_vector( g, G_, q );
 
-			//real_type dump = vector_traits::length_sq( g );
-			// ł҂Ԃ̗}
+				//real_type dump = vector_traits::length_sq( g );
+				// ł҂Ԃ̗}
 
-			g += current_center_;
+				g += current_center_;
+			}
 								
-			vector_type velocity_dt = ( g - p.new_position ) * rest;
-			p.free_position = p.new_position;
+			vector_type d = g - p.new_position;
+			real_type dd = math< Traits >::length_sq( d );
+			if( residual < dd ) { residual = dd; }
+
+			vector_type velocity_dt = d * rest;
+			if( first_pass ) { p.free_position = p.new_position; }
 			p.new_position += velocity_dt;
 			p.view_vector0 = p.new_position;
 			p.check();
 		}
+
+		// crushed̂Ƃ͉xĂȂ̂ŔȂ
+		if( !crushed_ ) {
+			shape_residual_ = real_type( sqrt( residual ) );
+		}
 	}
 
 	void update_display_matrix_internal()
@@ -616,11 +890,19 @@ private:
 		Traits::make_matrix(
 			orientation_matrix_, R_, tic + current_center_ );
 
-		real_type G[9];
-		math< Traits >::multiply_matrix( G, G_, criterion_ );
-		math< Traits >::transform_vector( tic, G, ic );
+		math< Traits >::multiply_matrix( display_G_, G_, criterion_ );
+		math< Traits >::transform_vector( tic, display_G_, ic );
+		display_t_ = tic + current_center_;
 		Traits::make_matrix(
-			deformed_matrix_, G, tic + current_center_ );
+			deformed_matrix_, display_G_, display_t_ );
+	}
+
+	void store_display_state()
+	{
+		for( int i = 0 ; i < 9 ; i++ ) {
+			previous_display_G_[i] = display_G_[i];
+		}
+		previous_display_t_ = display_t_;
 	}
 
 	void update_boundingbox_internal()
@@ -676,6 +958,7 @@ private:
 					freezing_duration_ ) {
 					this->set_frozen( true );
 					freezing_duration_ = 0;
+					leave_rigid();
 #if 0
 					for( typename points_type::iterator i =
 							 points.begin() ;
@@ -703,11 +986,284 @@ private:
 			}
 		}
 		this->set_defrosting( false );
+
+		update_rigid( dt, idt );
+	}
+
+	void update_rigid( real_type dt, real_type idt )
+	{
+		if( !rigid_proxy_enabled_ || rigid_ ) { return; }
+		if( this->get_frozen() || crushed_ ) {
+			rigid_duration_ = 0;
+			return;
+		}
+
+		// ڐG܂߂̕ό`̑傫
+		points_type& points = this->get_mesh()->get_points();
+		real_type max_dd = 0;
+		for( typename points_type::const_iterator i = points.begin() ;
+			 i != points.end() ;
+			 ++i ) {
+			const point_type& p = *i;
+			vector_type g;
+			math< Traits >::transform_vector( g, G_, p.ideal_offset );
+			g += current_center_;
+			real_type dd = math< Traits >::length_sq( p.new_position - g );
+			if( max_dd < dd ) { max_dd = dd; }
+		}
+		if( rigid_enter_residual_ * rigid_enter_residual_ <= max_dd ) {
+			rigid_duration_ = 0;
+			return;
+		}
+
+		rigid_duration_ += dt;
+		if( rigid_duration_ < rigid_enter_duration_ ) { return; }
+
+		enter_rigid( idt );
+	}
+
+	// ̓_̏Ԃ獄̂̏Ԃ
+	//	 ό`͓_̂(S = R^T G)̂܂܎^
+	void enter_rigid( real_type idt )
+	{
+		points_type& points = this->get_mesh()->get_points();
+
+		real_type Rt[9];
+		math< Traits >::transpose_matrix( Rt, R_ );
+		math< Traits >::multiply_matrix( rigid_S_, Rt, G_ );
+
+		// ʒS(̍Wn)AdSA^
+		vector_type v0 = math< Traits >::vector_zero();
+		real_type mass = 0;
+		vector_type offset = v0;
+		vector_type center = v0;
+		vector_type momentum = v0;
+		for( typename points_type::const_iterator i = points.begin() ;
+			 i != points.end() ;
+			 ++i ) {
+			const point_type& p = *i;
+			vector_type s;
+			math< Traits >::transform_vector( s, rigid_S_, p.ideal_offset );
+			mass += p.mass;
+			offset += s * p.mass;
+			center += p.new_position * p.mass;
+			momentum += ( p.new_position - p.old_position ) * p.mass;
+		}
+		real_type imass = real_type( 1.0 ) / mass;
+		rigid_mass_ = mass;
+		rigid_offset_ = offset * imass;
+		rigid_velocity_ = momentum * ( imass * idt );
+
+		// e\(̍Wn)Ɗp^
+		real_type I[9] = { 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+		vector_type angular_momentum = v0;
+		center *= imass;
+		for( typename points_type::const_iterator i = points.begin() ;
+			 i != points.end() ;
+			 ++i ) {
+			const point_type& p = *i;
+			vector_type s;
+			math< Traits >::transform_vector( s, rigid_S_, p.ideal_offset );
+			s -= rigid_offset_;
+
+			real_type x = vector_traits::x( s );
+			real_type y = vector_traits::y( s );
+			real_type z = vector_traits::z( s );
+			real_type m = p.mass;
+			I[0] += m * ( y * y + z * z );
+			I[1] -= m * x * y;
+			I[2] -= m * x * z;
+			I[4] += m * ( x * x + z * z );
+			I[5] -= m * y * z;
+			I[8] += m * ( x * x + y * y );
+
+			angular_momentum += math< Traits >::cross(
+				p.new_position - center,
+				p.new_position - p.old_position ) * m;
+		}
+		I[3] = I[1];
+		I[6] = I[2];
+		I[7] = I[5];
+		math< Traits >::inverse_matrix( rigid_inverse_inertia_, I );
+		rigid_angular_momentum_ = angular_momentum * idt;
+
+		// _̂̈ʒuɂ낦(enter_residual)
+		vector_type R_offset;
+		math< Traits >::transform_vector( R_offset, R_, rigid_offset_ );
+		current_center_ = center - R_offset;
+		for( typename points_type::iterator i = points.begin() ;
+			 i != points.end() ;
+			 ++i ) {
+			point_type& p = *i;
+			vector_type g;
+			math< Traits >::transform_vector( g, G_, p.ideal_offset );
+			g += current_center_;
+			p.old_position += g - p.new_position;
+			p.new_position = g;
+		}
+
+		rigid_ = true;
+		rigid_duration_ = 0;
+	}
+
+	void leave_rigid()
+	{
+		rigid_ = false;
+		rigid_duration_ = 0;
+	}
+
+	// ̂Ƃ1Xebvi߂ē_蒼
+	//	 OXebv̐ڐGœ_ꂽ͌͂ƂĎ荞
+	//	 (_Ƃɂ̓_ꂾ͂߁AڐG_̐ŕς)B
+	//	 傫_̂ɖ߂falseԂ(_͂̂܂܏_̂̌vZɉ)
+	bool compute_rigid_motion(
+		real_type dt,
+		real_type idt,
+		real_type drag_coefficient,
+		real_type dump_factor )
+	{
+		points_type& points = this->get_mesh()->get_points();
+
+		vector_type v0 = math< Traits >::vector_zero();
+		vector_type R_offset;
+		math< Traits >::transform_vector( R_offset, R_, rigid_offset_ );
+		vector_type center = current_center_ + R_offset;
+		real_type imass = real_type( 1.0 ) / rigid_mass_;
+
+		// [hWn̋te\ R I^-1 R^T
+		real_type Rt[9];
+		real_type tmp[9];
+		real_type inverse_inertia[9];
+		math< Traits >::transpose_matrix( Rt, R_ );
+		math< Traits >::multiply_matrix( tmp, R_, rigid_inverse_inertia_ );
+		math< Traits >::multiply_matrix( inverse_inertia, tmp, Rt );
+
+		// ڐGɂψʂƓ_ɂ͂W߂
+		//	 ĂȂ_͍蒼ƂƓvZȂ̂ł0
+		vector_type impulse = v0;
+		vector_type angular_impulse = v0;
+		vector_type force = this->get_force();
+		vector_type torque = v0;
+		real_type max_dd = 0;
+		int contact_count = 0;
+		for( typename points_type::iterator i = points.begin() ;
+			 i != points.end() ;
+			 ++i ) {
+			point_type& p = *i;
+			vector_type g;
+			math< Traits >::transform_vector( g, G_, p.ideal_offset );
+			g += current_center_;
+
+			vector_type r = g - center;
+			force += p.forces;
+			torque += math< Traits >::cross( r, p.forces );
+
+			vector_type d = p.new_position - g;
+			real_type dd = math< Traits >::length_sq( d );
+			if( dd == 0 ) { continue; }
+			if( max_dd < dd ) { max_dd = dd; }
+
+			// ďɒPʌ͂Ƃ̂̓_̓
+			vector_type n = d * ( real_type( 1.0 ) / real_type( sqrt( dd ) ) );
+			vector_type rn = math< Traits >::cross( r, n );
+			vector_type irn;
+			math< Traits >::transform_vector( irn, inverse_inertia, rn );
+			real_type k = imass + math< Traits >::dot( irn, rn );
+
+			vector_type j = d * ( real_type( 1.0 ) / k );
+			impulse += j;
+			angular_impulse += math< Traits >::cross( r, j );
+			contact_count++;
+		}
+
+		if( rigid_exit_velocity_ * rigid_exit_velocity_ <
+			max_dd * idt * idt ) {
+			leave_rigid();
+			return false;
+		}
+
+		// ڐG̕ψ: ʒuƉ]𒼂āAxɂ
+		vector_type theta = v0;
+		if( 0 < contact_count ) {
+			real_type ic = real_type( 1.0 ) / contact_count;
+			impulse *= ic;
+			angular_impulse *= ic;
+
+			vector_type displacement = impulse * imass;
+			center += displacement;
+			rigid_velocity_ += displacement * idt;
+
+			math< Traits >::transform_vector(
+				theta, inverse_inertia, angular_impulse );
+			rigid_angular_momentum_ += angular_impulse * idt;
+		}
+
+		// 
+		rigid_velocity_ +=
+			force * ( dt * imass ) + this->get_global_force() * dt;
+		rigid_angular_momentum_ += torque * dt;
+
+		// R(_Ƃł͂ȂdS̑ŋߎ)
+		real_type drag_factor = real_type( 1.0 ) -
+			math< Traits >::length_sq( rigid_velocity_ ) *
+			drag_coefficient;
+		if( drag_factor < 0 ) { drag_factor = 0; }
+		rigid_velocity_ *= drag_factor * dump_factor;
+		rigid_angular_momentum_ *= drag_factor * dump_factor;
+
+		// ϕ
+		center += rigid_velocity_ * dt;
+
+		vector_type omega;
+		math< Traits >::transform_vector(
+			omega, inverse_inertia, rigid_angular_momentum_ );
+		theta += omega * dt;
+
+		real_type dR[9];
+		real_type R[9];
+		math< Traits >::make_rotation_matrix( dR, theta );
+		math< Traits >::multiply_matrix( R, dR, R_ );
+		math< Traits >::orthonormalize_matrix( R );
+		math< Traits >::copy_matrix( R_, R );
+		math< Traits >::multiply_matrix( G_, R_, rigid_S_ );
+
+		math< Traits >::transform_vector( R_offset, R_, rigid_offset_ );
+		current_center_ = center - R_offset;
+
+		// _蒼
+		for( typename points_type::iterator i = points.begin() ;
+			 i != points.end() ;
+			 ++i ) {
+			point_type& p = *i;
+
+			p.constraint_pushout = v0;
+			p.active_contact_pushout = v0;
+			p.passive_contact_pushout = v0;
+			p.forces = v0;
+
+			vector_type g;
+			math< Traits >::transform_vector( g, G_, p.ideal_offset );
+			g += current_center_;
+
+			p.old_position = p.new_position;
+			p.new_position = g;
+			p.free_position = g;
+			p.view_vector0 = g;
+			p.tmp_velocity = g - p.old_position;
+			p.velocity = p.tmp_velocity * idt;
+			p.energy = math< Traits >::length_sq( p.velocity ) * p.mass * 0.5f;
+		}
+
+		this->set_force( v0 );
+		return true;
 	}
 
 	void end_frame_internal()
 	{
 		touch_level_ = 0;
+
+		// ʖ@͂̃Xebv̍ŏIʒuō蒼
+		this->invalidate_face_normals();
 	}
 
 	void move_internal( const vector_type& v )
@@ -767,6 +1323,19 @@ private:
 		set_touch_level( 1 );
 	}
 
+	void reset_internal()
+	{
+		// _̏ԂPrefabȂǂ̌ĂяoŖ߂Ă
+		this->reset_state();
+		freezing_duration_ = 0;
+		crush_duration_ = 0;
+		crushed_ = false;
+		math< Traits >::make_identity( R_ );
+		math< Traits >::make_identity( G_ );
+		touch_level_ = 2;
+		regularize();
+	}
+
 	void update_mass_internal()
 	{
 		set_touch_level( 2 );
@@ -778,7 +1347,7 @@ private:
 		set_touch_level( 2 );
 	}
 
-	void mark_border_edges_internal( EdgeFaceSpatialHash< Traits >& hash )
+	void mark_border_edges_internal( VolumeFaceSpatialHash< Traits >& hash )
 	{
 		points_type& points = this->get_mesh()->get_points();
 
@@ -806,9 +1375,7 @@ private:
 			const points_type& points = this->get_mesh()->get_points();
 			const faces_type& faces = this->get_mesh()->get_faces();
 
-			SegmentTriangleSpatialHash< Traits > hash(
-				this->get_mesh()->get_average_edge_length(), 4999 );
-			hash.add_segment( s0, s1 );
+			SegmentTrianglePicker< Traits > hash( s0, s1 );
 			for( typename faces_type::const_iterator i =
 					 faces.begin() ;
 				 i != faces.end() ;
@@ -865,6 +1432,8 @@ private:
 
 	void regularize_internal()
 	{
+		leave_rigid();
+
 		points_type& points = this->get_mesh()->get_points();
 		faces_type& faces = this->get_mesh()->get_faces();
 
@@ -899,6 +1468,447 @@ private:
 		calculate_Aqq();
 		calculate_center();
 		make_normals();
+		build_clusters();
+	}
+
+	// NX^
+	//	 ZƂ̒l̕
+	enum {
+		// `(build_clustersō)
+		CLUSTER_REST_MASS			= 0,
+		CLUSTER_REST_Q				= 1,	// mq
+		CLUSTER_REST_QQ				= 4,	// mqq^T(Ƃ)
+		CLUSTER_REST_INVERSE_AQQ	= 4,	// Aqq^-1
+		CLUSTER_REST_VALID			= 13,
+		CLUSTER_REST_COUNT			= 14,	// _̐
+		CLUSTER_REST_STRIDE			= 15,
+
+		// Xebv̘a
+		CLUSTER_SUM_X				= 0,	// mx
+		CLUSTER_SUM_XQ				= 3,	// mxq^T
+		CLUSTER_SUM_STRIDE			= 12,
+
+		// ڕWʒu g = G q + t ̕
+		CLUSTER_GOAL_G				= 0,
+		CLUSTER_GOAL_T				= 9,
+		CLUSTER_GOAL_STRIDE			= 12,
+
+		CLUSTER_ROTATION_ITERATIONS = 4,
+		CLUSTER_MIN_POINTS			= 8,	// 菭ȂNX^͎gȂ
+	};
+
+	void build_clusters()
+	{
+		cluster_point_cells_.clear();
+		if( cluster_divisions_ == 0 ) { return; }
+
+		points_type& points = this->get_mesh()->get_points();
+
+		// iq
+		vector_type bbmin = math< Traits >::vector_max();
+		vector_type bbmax = math< Traits >::vector_min();
+		for( typename points_type::const_iterator i = points.begin() ;
+			 i != points.end() ;
+			 ++i ) {
+			math< Traits >::update_bb( bbmin, bbmax, (*i).ideal_offset );
+		}
+		vector_type extent = bbmax - bbmin;
+		real_type e[3] = {
+			vector_traits::x( extent ),
+			vector_traits::y( extent ),
+			vector_traits::z( extent ),
+		};
+		real_type longest = std::max( e[0], std::max( e[1], e[2] ) );
+		real_type cell = longest / cluster_divisions_;
+		if( cell <= 0 ) { cell = 1; }
+		real_type icell = real_type( 1.0 ) / cell;
+		int total = 1;
+		for( int k = 0 ; k < 3 ; k++ ) {
+			cluster_size_[k] =
+				std::min( int( e[k] * icell ), cluster_divisions_ - 1 ) + 1;
+			total *= cluster_size_[k];
+		}
+
+		cluster_rest_.assign( total * CLUSTER_REST_STRIDE, 0 );
+		cluster_sums_.assign( total * CLUSTER_SUM_STRIDE, 0 );
+		cluster_goals_.assign( total * CLUSTER_GOAL_STRIDE, 0 );
+		cluster_cover_.assign( total, 0 );
+		cluster_rotations_.resize( total * 9 );
+		for( int c = 0 ; c < total ; c++ ) {
+			math< Traits >::copy_matrix( &cluster_rotations_[c * 9], R_ );
+		}
+		cluster_prefix_.resize(
+			( std::max( cluster_size_[0],
+						std::max( cluster_size_[1], cluster_size_[2] ) ) + 1 ) *
+			CLUSTER_REST_STRIDE );
+
+		// _̏ƃZƂ̎ʁE1E2[g
+		for( typename points_type::const_iterator i = points.begin() ;
+			 i != points.end() ;
+			 ++i ) {
+			const point_type& p = *i;
+			vector_type d = ( p.ideal_offset - bbmin ) * icell;
+			int c[3] = {
+				int( vector_traits::x( d ) ),
+				int( vector_traits::y( d ) ),
+				int( vector_traits::z( d ) ),
+			};
+			for( int k = 0 ; k < 3 ; k++ ) {
+				c[k] = std::max( 0, std::min( c[k], cluster_size_[k] - 1 ) );
+			}
+			int index =
+				c[0] + cluster_size_[0] * ( c[1] + cluster_size_[1] * c[2] );
+			cluster_point_cells_.push_back( index );
+
+			real_type q[3] = {
+				vector_traits::x( p.ideal_offset ),
+				vector_traits::y( p.ideal_offset ),
+				vector_traits::z( p.ideal_offset ),
+			};
+			real_type* r = &cluster_rest_[index * CLUSTER_REST_STRIDE];
+			r[CLUSTER_REST_MASS] += p.mass;
+			r[CLUSTER_REST_COUNT] += 1;
+			for( int j = 0 ; j < 3 ; j++ ) {
+				r[CLUSTER_REST_Q + j] += p.mass * q[j];
+				for( int k = 0 ; k < 3 ; k++ ) {
+					r[CLUSTER_REST_QQ + j * 3 + k] += p.mass * q[j] * q[k];
+				}
+			}
+		}
+
+		// S
+		for( int k = 0 ; k < CLUSTER_REST_STRIDE ; k++ ) {
+			cluster_whole_rest_[k] = 0;
+		}
+		for( int c = 0 ; c < total ; c++ ) {
+			for( int k = 0 ; k < CLUSTER_REST_STRIDE ; k++ ) {
+				cluster_whole_rest_[k] +=
+					cluster_rest_[c * CLUSTER_REST_STRIDE + k];
+			}
+		}
+		make_cluster_rest( cluster_whole_rest_ );
+
+		// NX^͈̔͂ɍLAqq^-1ɂ
+		//	 NX^͓_܂ރZ𒆐Sɂ̂
+		for( int c = 0 ; c < total ; c++ ) {
+			cluster_cover_[c] =
+				cluster_rest_[c * CLUSTER_REST_STRIDE + CLUSTER_REST_COUNT];
+		}
+		sum_cluster_window( cluster_rest_, CLUSTER_REST_STRIDE );
+		for( int c = 0 ; c < total ; c++ ) {
+			real_type* r = &cluster_rest_[c * CLUSTER_REST_STRIDE];
+			make_cluster_rest( r );
+			if( cluster_cover_[c] == 0 ) { r[CLUSTER_REST_VALID] = 0; }
+		}
+
+		// Z܂ޗLȃNX^̐
+		for( int c = 0 ; c < total ; c++ ) {
+			cluster_cover_[c] =
+				cluster_rest_[c * CLUSTER_REST_STRIDE + CLUSTER_REST_VALID];
+		}
+		sum_cluster_window( cluster_cover_, 1 );
+		for( int c = 0 ; c < total ; c++ ) {
+			if( 0 < cluster_cover_[c] ) {
+				cluster_cover_[c] = real_type( 1.0 ) / cluster_cover_[c];
+			}
+		}
+	}
+
+	// ʂƃ[g̘aAqq^-1
+	void make_cluster_rest( real_type* r )
+	{
+		r[CLUSTER_REST_VALID] = 0;
+		real_type m = r[CLUSTER_REST_MASS];
+		if( m <= 0 || r[CLUSTER_REST_COUNT] < CLUSTER_MIN_POINTS ) { return; }
+
+		real_type Aqq[9];
+		for( int j = 0 ; j < 3 ; j++ ) {
+			for( int k = 0 ; k < 3 ; k++ ) {
+				Aqq[j * 3 + k] =
+					r[CLUSTER_REST_QQ + j * 3 + k] -
+					r[CLUSTER_REST_Q + j] * r[CLUSTER_REST_Q + k] / m;
+			}
+		}
+
+		// _ʁEɕԃNX^͉]܂Ȃ̂ŎgȂ
+		real_type trace = ( Aqq[0] + Aqq[4] + Aqq[8] ) / 3;
+		real_type det = math< Traits >::determinant_matrix( Aqq );
+		if( det <= trace * trace * trace * real_type( 0.001 ) ) { return; }
+
+		math< Traits >::inverse_matrix( &r[CLUSTER_REST_INVERSE_AQQ], Aqq );
+		r[CLUSTER_REST_VALID] = 1;
+	}
+
+	// eZɂ̃ZOcluster_width_͈̘̔͂a
+	//	 ƂɗݐϘa̍Ƃ̂Ŕ͈͂̑傫ɂȂ
+	void sum_cluster_window( std::vector< real_type >& a, int stride )
+	{
+		const int w = cluster_width_;
+		const int step[3] = {
+			1, cluster_size_[0], cluster_size_[0] * cluster_size_[1]
+		};
+		real_type* prefix = &cluster_prefix_[0];
+
+		for( int axis = 0 ; axis < 3 ; axis++ ) {
+			const int n = cluster_size_[axis];
+			const int s = step[axis] * stride;
+			const int a0 = ( axis + 1 ) % 3;
+			const int a1 = ( axis + 2 ) % 3;
+			for( int i1 = 0 ; i1 < cluster_size_[a1] ; i1++ ) {
+				for( int i0 = 0 ; i0 < cluster_size_[a0] ; i0++ ) {
+					real_type* line =
+						&a[( i0 * step[a0] + i1 * step[a1] ) * stride];
+
+					for( int k = 0 ; k < stride ; k++ ) { prefix[k] = 0; }
+					for( int i = 0 ; i < n ; i++ ) {
+						for( int k = 0 ; k < stride ; k++ ) {
+							prefix[( i + 1 ) * stride + k] =
+								prefix[i * stride + k] + line[i * s + k];
+						}
+					}
+					for( int i = 0 ; i < n ; i++ ) {
+						int lo = std::max( 0, i - w ) * stride;
+						int hi = std::min( n, i + w + 1 ) * stride;
+						for( int k = 0 ; k < stride ; k++ ) {
+							line[i * s + k] = prefix[hi + k] - prefix[lo + k];
+						}
+					}
+				}
+			}
+		}
+	}
+
+	// Ŝ̐Î~`󂪎gȂ(ʁEA_Ȃ)Ƃ
+	// NX^S1̌`󍇂킹ɂ
+	bool clustered_internal() const
+	{
+		return 0 < cluster_divisions_ &&
+			cluster_whole_rest_[CLUSTER_REST_VALID] != 0;
+	}
+
+	void match_clusters()
+	{
+		points_type& points = this->get_mesh()->get_points();
+		const int total = int( cluster_cover_.size() );
+
+		// ZƂ̘a(Ȃ悤ȌdS̑Έʒu)
+		vector_type origin = current_center_;
+		std::fill( cluster_sums_.begin(), cluster_sums_.end(), real_type( 0 ) );
+		int ii = 0;
+		for( typename points_type::const_iterator i = points.begin() ;
+			 i != points.end() ;
+			 ++i, ++ii ) {
+			const point_type& p = *i;
+			vector_type x = ( p.new_position - origin ) * p.mass;
+			real_type mx[3] = {
+				vector_traits::x( x ),
+				vector_traits::y( x ),
+				vector_traits::z( x ),
+			};
+			real_type q[3] = {
+				vector_traits::x( p.ideal_offset ),
+				vector_traits::y( p.ideal_offset ),
+				vector_traits::z( p.ideal_offset ),
+			};
+			real_type* r =
+				&cluster_sums_[cluster_point_cells_[ii] * CLUSTER_SUM_STRIDE];
+			for( int j = 0 ; j < 3 ; j++ ) {
+				r[CLUSTER_SUM_X + j] += mx[j];
+				for( int k = 0 ; k < 3 ; k++ ) {
+					r[CLUSTER_SUM_XQ + j * 3 + k] += mx[j] * q[k];
+				}
+			}
+		}
+
+		// S(\EՓˁELODȂǂgR_, G_, current_center_)
+		real_type whole[CLUSTER_SUM_STRIDE];
+		for( int k = 0 ; k < CLUSTER_SUM_STRIDE ; k++ ) { whole[k] = 0; }
+		for( int c = 0 ; c < total ; c++ ) {
+			for( int k = 0 ; k < CLUSTER_SUM_STRIDE ; k++ ) {
+				whole[k] += cluster_sums_[c * CLUSTER_SUM_STRIDE + k];
+			}
+		}
+		real_type detA;
+		match_cluster(
+			whole,
+			cluster_whole_rest_,
+			&cluster_whole_rest_[CLUSTER_REST_INVERSE_AQQ],
+			origin, R_, G_, current_center_, detA );
+#if PARTIX_SOFTVOLUME_CRUSH_TEST
+		// PNX^match_shape_internalƓŜɑ΂čs
+		real_type detR = math< Traits >::determinant_matrix( R_ );
+		if( 0.7f < std::abs( 1.0f - detR ) ||
+			0.5f < std::abs( real_type( 1.0 ) - detA ) ) {
+			crushed_ = true;
+		}
+#endif
+
+		// NX^
+		distortion_ = 0;
+		sum_cluster_window( cluster_sums_, CLUSTER_SUM_STRIDE );
+		for( int c = 0 ; c < total ; c++ ) {
+			const real_type* r = &cluster_rest_[c * CLUSTER_REST_STRIDE];
+			real_type* g = &cluster_goals_[c * CLUSTER_GOAL_STRIDE];
+			if( r[CLUSTER_REST_VALID] == 0 ) {
+				for( int k = 0 ; k < CLUSTER_GOAL_STRIDE ; k++ ) { g[k] = 0; }
+				continue;
+			}
+
+			real_type G[9];
+			vector_type t;
+			real_type cluster_detA;
+			real_type distortion = match_cluster(
+				&cluster_sums_[c * CLUSTER_SUM_STRIDE],
+				r,
+				&r[CLUSTER_REST_INVERSE_AQQ],
+				origin, &cluster_rotations_[c * 9], G, t, cluster_detA );
+			if( distortion_ < distortion ) { distortion_ = distortion; }
+
+			for( int k = 0 ; k < 9 ; k++ ) { g[CLUSTER_GOAL_G + k] = G[k]; }
+			g[CLUSTER_GOAL_T + 0] = vector_traits::x( t );
+			g[CLUSTER_GOAL_T + 1] = vector_traits::y( t );
+			g[CLUSTER_GOAL_T + 2] = vector_traits::z( t );
+		}
+
+		// _܂ރNX^̕ςeZ
+		sum_cluster_window( cluster_goals_, CLUSTER_GOAL_STRIDE );
+		for( int c = 0 ; c < total ; c++ ) {
+			real_type* g = &cluster_goals_[c * CLUSTER_GOAL_STRIDE];
+			for( int k = 0 ; k < CLUSTER_GOAL_STRIDE ; k++ ) {
+				g[k] *= cluster_cover_[c];
+			}
+		}
+	}
+
+	// NX^1̌`󍇂킹
+	//	 R͑Ỏ]Ă(lɉ]߂)B
+	//	 ڕWʒug = G q + ť`ŁAA̍s񎮂detAɕԂB
+	//	 ߂ldistortion
+	real_type match_cluster(
+		const real_type*	sums,
+		const real_type*	rest,
+		const real_type*	inverse_Aqq,
+		const vector_type&	origin,
+		real_type*			R,
+		real_type*			G,
+		vector_type&		t,
+		real_type&			detA )
+	{
+		real_type m = rest[CLUSTER_REST_MASS];
+		real_type im = real_type( 1.0 ) / m;
+		const real_type* mx = &sums[CLUSTER_SUM_X];
+		const real_type* mq = &rest[CLUSTER_REST_Q];
+
+		// Apq = m(x - cx)(q - cq)^T = mxq^T - (mx)(mq)^T / m
+		real_type Apq[9];
+		for( int j = 0 ; j < 3 ; j++ ) {
+			for( int k = 0 ; k < 3 ; k++ ) {
+				Apq[j * 3 + k] =
+					sums[CLUSTER_SUM_XQ + j * 3 + k] - mx[j] * mq[k] * im;
+			}
+		}
+
+		math< Traits >::extract_rotation( R, Apq, CLUSTER_ROTATION_ITERATIONS );
+
+		real_type A[9];
+		math< Traits >::multiply_matrix( A, Apq, inverse_Aqq );
+		detA = math< Traits >::determinant_matrix( A );
+		real_type detR = math< Traits >::determinant_matrix( R );
+		real_type distortion = std::max(
+			std::abs( real_type( 1.0 ) - detA ),
+			std::abs( real_type( 1.0 ) - detR ) );
+
+		if( 0 < detA ) {
+			real_type cbrt = pow( detA, real_type( 1.0/3.0 ) );
+			real_type Adash[9];
+			math< Traits >::multiply_matrix(
+				Adash, A, real_type( 1.0 ) / cbrt );
+
+			real_type G0[9];
+			real_type G1[9];
+			math< Traits >::multiply_matrix( G0, Adash, stretch_factor_ );
+			math< Traits >::multiply_matrix(
+				G1, R, real_type( 1.0 ) - stretch_factor_ );
+			math< Traits >::add_matrix( G, G0, G1 );
+		} else {
+			// ԂNX^͐LтgȂ
+			math< Traits >::copy_matrix( G, R );
+		}
+
+		// t = cx - G cq
+		vector_type cx = origin;
+		vector_traits::x( cx, vector_traits::x( cx ) + mx[0] * im );
+		vector_traits::y( cx, vector_traits::y( cx ) + mx[1] * im );
+		vector_traits::z( cx, vector_traits::z( cx ) + mx[2] * im );
+		vector_type cq = math< Traits >::vector_zero();
+		vector_traits::x( cq, mq[0] * im );
+		vector_traits::y( cq, mq[1] * im );
+		vector_traits::z( cq, mq[2] * im );
+		vector_type Gcq;
+		math< Traits >::transform_vector( Gcq, G, cq );
+		t = cx - Gcq;
+
+		return distortion;
+	}
+
+	// _(ZcellAʒuq)̖ڕWʒu
+	//	 ܂܂LȃNX^Ȃfalse(Ŝ̌`󍇂킹g)
+	bool cluster_goal( vector_type& g, int cell, const vector_type& q )
+	{
+		if( cluster_cover_[cell] == 0 ) { return false; }
+		const real_type* c = &cluster_goals_[cell * CLUSTER_GOAL_STRIDE];
+		math< Traits >::transform_vector( g, &c[CLUSTER_GOAL_G], q );
+		vector_traits::x( g, vector_traits::x( g ) + c[CLUSTER_GOAL_T + 0] );
+		vector_traits::y( g, vector_traits::y( g ) + c[CLUSTER_GOAL_T + 1] );
+		vector_traits::z( g, vector_traits::z( g ) + c[CLUSTER_GOAL_T + 2] );
+		return true;
+	}
+
+	void fit_linear_displacement_internal( real_type* M, vector_type& dc )
+	{
+		points_type& points = this->get_mesh()->get_points();
+
+		dc = math< Traits >::vector_zero();
+		real_type total_mass = 0;
+		for( typename points_type::iterator i = points.begin() ;
+			 i != points.end() ;
+			 ++i ) {
+			point_type& p = *i;
+			dc += ( p.new_position - p.old_position ) * p.mass;
+			total_mass += p.mass;
+		}
+		dc *= real_type( 1.0 ) / total_mass;
+
+		real_type Adq[9] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, };
+		for( typename points_type::iterator i = points.begin() ;
+			 i != points.end() ;
+			 ++i ) {
+			point_type& p = *i;
+			if( !p.surface ) { continue; }
+
+			vector_type d = p.new_position - p.old_position - dc;
+			const vector_type& q = p.ideal_offset;
+
+			real_type dx = vector_traits::x( d );
+			real_type dy = vector_traits::y( d );
+			real_type dz = vector_traits::z( d );
+			real_type qx = vector_traits::x( q );
+			real_type qy = vector_traits::y( q );
+			real_type qz = vector_traits::z( q );
+
+			real_type m = p.mass;
+
+			Adq[0] += m * dx * qx;
+			Adq[1] += m * dx * qy;
+			Adq[2] += m * dx * qz;
+			Adq[3] += m * dy * qx;
+			Adq[4] += m * dy * qy;
+			Adq[5] += m * dy * qz;
+			Adq[6] += m * dz * qx;
+			Adq[7] += m * dz * qy;
+			Adq[8] += m * dz * qz;
+		}
+		math< Traits >::multiply_matrix( M, Adq, Aqq_ );
 	}
 
 	void calculate_Aqq()
@@ -1254,6 +2264,10 @@ private:
 	vector_type		current_center_;
 	matrix_type		deformed_matrix_;
 	matrix_type		orientation_matrix_;
+	real_type		display_G_[9];
+	vector_type		display_t_;
+	real_type		previous_display_G_[9];
+	vector_type		previous_display_t_;
 	vector_type		bbmin_;
 	vector_type		bbmax_;
 	real_type		Aqq_[9];
@@ -1265,6 +2279,36 @@ private:
 	real_type		freezing_duration_;
 	bool			crushed_;
 	real_type		crush_duration_;
+	bool			shape_restored_;	// ̃Xebvrestore_shape
+	real_type		distortion_;
+	real_type		shape_residual_;
+
+	// ̋ߎ
+	bool			rigid_proxy_enabled_;
+	real_type		rigid_enter_residual_;
+	real_type		rigid_enter_duration_;
+	real_type		rigid_exit_velocity_;
+	bool			rigid_;
+	real_type		rigid_duration_;
+	real_type		rigid_mass_;
+	vector_type		rigid_offset_;				// ̍Wn̎ʒS
+	real_type		rigid_S_[9];				// _̕ό`
+	real_type		rigid_inverse_inertia_[9];	// ̍Wn
+	vector_type		rigid_velocity_;
+	vector_type		rigid_angular_momentum_;
+
+	// NX^
+	int							cluster_divisions_;
+	int							cluster_width_;
+	int							cluster_size_[3];
+	std::vector< int >			cluster_point_cells_;
+	std::vector< real_type >	cluster_rest_;
+	std::vector< real_type >	cluster_sums_;
+	std::vector< real_type >	cluster_goals_;
+	std::vector< real_type >	cluster_cover_;		// ܂ރNX^̋t
+	std::vector< real_type >	cluster_prefix_;
+	std::vector< real_type >	cluster_rotations_;	// Ỏ]
+	real_type					cluster_whole_rest_[CLUSTER_REST_STRIDE];
 
 	std::vector< Collidable< Traits >* >	neighbors_;
 	bool									marked_;
@@ -10,10 +10,12 @@
 
 #include "fixed_pool.hpp"
 #include "voxel_traverser.hpp"
+#include "cpu_ray_triangle_tester.hpp"
 #include "partix_forward.hpp"
 #include "partix_geometry.hpp"
 #include "partix_math.hpp"
 #include "partix_utilities.hpp"
+#include <vector>
 
 namespace partix {
 
@@ -45,6 +47,7 @@ public:
 	}
 
 	real_type gridsize() { return gridsize_; }
+	size_t tablesize() { return tablesize_; }
 
 protected:
 	SpatialHashBase( real_type gridsize, size_t tablesize )
@@ -78,8 +81,10 @@ public:
 public:
 	DirectSpatialHash(
 		real_type       gridsize,
-		int             tablesize )
+		int             tablesize,
+		page_arena&		arena = page_arena::instance() )
 		: SpatialHashBase< Traits >( gridsize, tablesize ),
+		  page_provider_( arena ),
 		  pool_( page_provider_, "dsh" )
 	{
 		table_ = new InternalNodePtr[ tablesize ];
@@ -137,8 +142,8 @@ public:
 	}
 
 protected:
-	default_page_provider										page_provider_;
-	fixed_pool< sizeof( InternalNode ), default_page_provider >     pool_;
+	arena_page_provider											page_provider_;
+	fixed_pool< sizeof( InternalNode ), arena_page_provider >       pool_;
 	InternalNodePtr*                                                table_;
 
 };
@@ -164,8 +169,10 @@ public:
 	IndirectSpatialHash(
 		real_type       gridsize,
 		int             tablesize,
-		const char*		name )
+		const char*		name,
+		page_arena&		arena = page_arena::instance() )
 		: SpatialHashBase< Traits >( gridsize, tablesize ),
+		  page_provider_( arena ),
 		  pool0_( page_provider_, name ),
 		  pool1_( page_provider_, name )
 	{
@@ -241,9 +248,9 @@ public:
 	}
 
 protected:
-	default_page_provider										page_provider_;
-	fixed_pool< sizeof( InternalNode ), default_page_provider >     pool0_;
-	fixed_pool< sizeof( InternalReferer ), default_page_provider >  pool1_;
+	arena_page_provider											page_provider_;
+	fixed_pool< sizeof( InternalNode ), arena_page_provider >       pool0_;
+	fixed_pool< sizeof( InternalReferer ), arena_page_provider >    pool1_;
 	InternalRefererPtr*                                             table_;
 
 };
@@ -259,11 +266,15 @@ protected:
 
 ////////////////////////////////////////////////////////////////
 // segment - triangle
-template < class Traits >
+//	 Tester̓ZƂsegment1{ƎOp`packet𔻒肷
+template < class Traits,
+		   class Tester = RayTrianglePacketTester<
+			   typename Traits::vector_traits, 8 > >
 class SegmentTriangleSpatialHash {
 private:
 	typedef typename Traits::real_type      real_type;
 	typedef typename Traits::vector_type    vector_type;
+	typedef typename Tester::triangle_packet_type triangle_packet_type;
 
 	struct SegmentHashNode {
 		vector_type     s0;
@@ -279,41 +290,15 @@ private:
 		vector_type     bbmax;
 	};
 
-	struct InternalCallback {
-	public:
-		InternalCallback( real_type& dist ) : dist_( dist ) {}
-		bool operator()(
-			const SegmentHashNode* p, const TriangleHashNode* q ) const
-		{
-			vector_type uvt;
-			if( !collide( p, q, uvt ) ) { return false; }
-			if( uvt.z < dist_ ) { dist_ = uvt.z; }
-			return false;
-		}
-
-	private:
-		bool collide(
-			const SegmentHashNode* pp,
-			const TriangleHashNode* qq,
-			vector_type& uvt ) const
-		{
-			if( !math< Traits >::test_aabb_aabb(
-					pp->bbmin, pp->bbmax, qq->bbmin, qq->bbmax ) ) {
-				return false;
-			}
-
-			const vector_type& s0 = pp->s0;
-			const vector_type& s1 = pp->s1;
+	typedef IndirectSpatialHash< Traits, SegmentHashNode >	active_table_type;
+	typedef IndirectSpatialHash< Traits, TriangleHashNode > passive_table_type;
 
-			const vector_type& v0 = qq->v0;
-			const vector_type& v1 = qq->v1;
-			const vector_type& v2 = qq->v2;
+	enum { packet_size = Tester::packet_size };
 
-			return math< Traits >::test_segment_triangle(
-				s0, s1, v0, v1, v2, uvt );
-		}
-        
-		real_type& dist_;
+	struct TriangleBatch {
+		triangle_packet_type	packet;
+		vector_type				bbmin[packet_size];
+		vector_type				bbmax[packet_size];
 	};
 
 public:
@@ -407,16 +392,147 @@ public:
 		}
 	}
 
+	// ZƂɎOp`packetɂ܂Ƃ߂āAsegment1{肷
 	bool apply( real_type& dist )
 	{
 		dist = math< Traits >::real_max();
-		passive_table_.apply( active_table_, InternalCallback( dist ) );
+
+		real_type u[packet_size], v[packet_size], t[packet_size];
+
+		size_t n = passive_table_.tablesize();
+		for( size_t i = 0 ; i < n ; i++ ) {
+			typename passive_table_type::table_entry_type q0 =
+				passive_table_.entry( i );
+			typename active_table_type::table_entry_type p0 =
+				active_table_.entry( i );
+			if( !q0 || !p0 ) { continue; }
+
+			int batch_count = 0;
+			for( typename passive_table_type::table_entry_type q = q0 ;
+				 q ;
+				 q = passive_table_.next( q ) ) {
+				const TriangleHashNode* tn = passive_table_.unwrap( q );
+				if( batch_count == 0 ||
+					batches_[batch_count-1].packet.count == packet_size ) {
+					if( int( batches_.size() ) == batch_count ) {
+						batches_.push_back( TriangleBatch() );
+					}
+					Tester::clear( batches_[batch_count++].packet );
+				}
+				TriangleBatch& b = batches_[batch_count-1];
+				int k = Tester::add_triangle(
+					b.packet, tn->v0, tn->v1, tn->v2 );
+				b.bbmin[k] = tn->bbmin;
+				b.bbmax[k] = tn->bbmax;
+			}
+
+			for( typename active_table_type::table_entry_type p = p0 ;
+				 p ;
+				 p = active_table_.next( p ) ) {
+				const SegmentHashNode* sn = active_table_.unwrap( p );
+				for( int j = 0 ; j < batch_count ; j++ ) {
+					const TriangleBatch& b = batches_[j];
+
+					unsigned int mask = 0;
+					for( int k = 0 ; k < b.packet.count ; k++ ) {
+						if( math< Traits >::test_aabb_aabb(
+								sn->bbmin, sn->bbmax,
+								b.bbmin[k], b.bbmax[k] ) ) {
+							mask |= 1u << k;
+						}
+					}
+					if( !mask ) { continue; }
+
+					mask &= Tester::test_triangles(
+						b.packet, sn->s0, sn->s1, u, v, t );
+					for( int k = 0 ; k < b.packet.count ; k++ ) {
+						if( ( mask & ( 1u << k ) ) && t[k] < dist ) {
+							dist = t[k];
+						}
+					}
+				}
+			}
+		}
+
 		return dist < math< Traits >::real_max();
 	}
 
 private:
-	IndirectSpatialHash< Traits, SegmentHashNode >  active_table_;
-	IndirectSpatialHash< Traits ,TriangleHashNode > passive_table_;
+	active_table_type				active_table_;
+	passive_table_type				passive_table_;
+	std::vector< TriangleBatch >	batches_;
+
+};
+
+////////////////////////////////////////////////////////////////
+// segment - triangle(segment1{)
+//	 segment1{ȂnbVɓĂOp`ʂ茩̂ƓȂ̂ŁA
+//	 AABBōiOp`packetɋl߂Ă̂܂ܔ肷B
+//	 X^bNゾōς݁A蓖Ă⋤L̏ԂȂ
+//	 (ʂSegmentTriangleSpatialHashƓ)
+template < class Traits,
+		   class Tester = RayTrianglePacketTester<
+			   typename Traits::vector_traits, 8 > >
+class SegmentTrianglePicker {
+private:
+	typedef typename Traits::real_type      real_type;
+	typedef typename Traits::vector_type    vector_type;
+	typedef typename Tester::triangle_packet_type triangle_packet_type;
+
+	enum { packet_size = Tester::packet_size };
+
+public:
+	SegmentTrianglePicker( const vector_type& s0, const vector_type& s1 )
+		: s0_( s0 ), s1_( s1 ), dist_( math< Traits >::real_max() )
+	{
+		math< Traits >::get_segment_bb( s0, s1, bbmin_, bbmax_ );
+		Tester::clear( packet_ );
+	}
+
+	void add_triangle(
+		const vector_type& v0,
+		const vector_type& v1,
+		const vector_type& v2 )
+	{
+		vector_type bbmin, bbmax;
+		math< Traits >::get_triangle_bb( v0, v1, v2, bbmin, bbmax );
+		if( !math< Traits >::test_aabb_aabb(
+				bbmin_, bbmax_, bbmin, bbmax ) ) {
+			return;
+		}
+
+		Tester::add_triangle( packet_, v0, v1, v2 );
+		if( packet_.count == packet_size ) { flush(); }
+	}
+
+	bool apply( real_type& dist )
+	{
+		flush();
+		dist = dist_;
+		return dist_ < math< Traits >::real_max();
+	}
+
+private:
+	void flush()
+	{
+		if( packet_.count == 0 ) { return; }
+
+		real_type u[packet_size], v[packet_size], t[packet_size];
+		unsigned int mask =
+			Tester::test_triangles( packet_, s0_, s1_, u, v, t );
+		for( int k = 0 ; k < packet_.count ; k++ ) {
+			if( ( mask & ( 1u << k ) ) && t[k] < dist_ ) { dist_ = t[k]; }
+		}
+		Tester::clear( packet_ );
+	}
+
+private:
+	vector_type				s0_;
+	vector_type				s1_;
+	vector_type				bbmin_;
+	vector_type				bbmax_;
+	real_type				dist_;
+	triangle_packet_type	packet_;
 
 };
 
@@ -589,12 +705,16 @@ private:
 
 ////////////////////////////////////////////////////////////////
 // ray - triangle
-template < class Traits, class RayLoad, class TriangleLoad >
+//	 Tester̓ZƂɎOp`1raypacket𔻒肷
+template < class Traits, class RayLoad, class TriangleLoad,
+		   class Tester = RayTrianglePacketTester<
+			   typename Traits::vector_traits, 8 > >
 class RayTriangleSpatialHash {
 private:
 	typedef typename Traits::vector_traits  vector_traits;
 	typedef typename Traits::real_type      real_type;
 	typedef typename Traits::vector_type    vector_type;
+	typedef typename Tester::ray_packet_type ray_packet_type;
 
 	struct RayHashNode {
 		vector_type     s0;
@@ -613,48 +733,25 @@ private:
 		TriangleLoad    load;
 	};
 
-	template < class CallBack >
-	struct InternalCallback {
-	public:
-		InternalCallback( const CallBack& c ) : c_( c ) {}
-		bool operator()(
-			const RayHashNode* p, const TriangleHashNode* q ) const
-		{
-			vector_type uvt;
-			if( !collide( p, q, uvt ) ) { return false; }
-			c_( p->load, q->load, uvt );
-			return false;
-		}
-
-	private:
-		bool collide(
-			const RayHashNode* pp,
-			const TriangleHashNode* qq,
-			vector_type& uvt ) const
-		{
-			if( !math< Traits >::test_aabb_aabb(
-					pp->bbmin, pp->bbmax, qq->bbmin, qq->bbmax ) ) {
-				return false;
-			}
+	typedef IndirectSpatialHash< Traits, RayHashNode >		active_table_type;
+	typedef IndirectSpatialHash< Traits, TriangleHashNode > passive_table_type;
 
-			const vector_type& s0 = pp->s0;
-			const vector_type& s1 = pp->s1;
+	enum { packet_size = Tester::packet_size };
 
-			const vector_type& v0 = qq->v0;
-			const vector_type& v1 = qq->v1;
-			const vector_type& v2 = qq->v2;
-
-			return math< Traits >::test_segment_triangle(
-				s0, s1, v0, v1, v2, uvt );
-		}
-
-		const CallBack& c_;
+	struct RayBatch {
+		ray_packet_type		packet;
+		vector_type			bbmin[packet_size];
+		vector_type			bbmax[packet_size];
+		RayHashNode*		nodes[packet_size];
 	};
 
 public:
-	RayTriangleSpatialHash( real_type gridsize, int tablesize )
-		: active_table_( gridsize, tablesize, "rt0" ),
-		  passive_table_( gridsize, tablesize, "rt1" )
+	RayTriangleSpatialHash(
+		real_type		gridsize,
+		int				tablesize,
+		page_arena&		arena = page_arena::instance() )
+		: active_table_( gridsize, tablesize, "rt0", arena ),
+		  passive_table_( gridsize, tablesize, "rt1", arena )
 	{
 	}
 	~RayTriangleSpatialHash()
@@ -686,6 +783,57 @@ public:
 		}
 	}
 
+	// ܂Ƃ߂Ēǉray̍ő吔
+	enum { RAY_PACKET_SIZE = 8 };
+
+	// őRAY_PACKET_SIZE{ray܂Ƃ߂Ēǉ
+	//	 DDAS[ɐi߁A΂΂
+	//	 c̃[1/4ȉɂȂ1{HB
+	//	 erayo^Zadd_rayƓ
+	void add_rays( const vector_type* s0, const vector_type* s1,
+				   const RayLoad* loads, int n )
+	{
+		assert( 0 <= n && n <= RAY_PACKET_SIZE );
+		if( n == 1 ) {
+			add_ray( s0[0], s1[0], loads[0] );
+			return;
+		}
+
+		RayHashNode* t[RAY_PACKET_SIZE];
+		for( int i = 0 ; i < n ; i++ ) {
+			t[i] = active_table_.alloc_node();
+			t[i]->s0 = s0[i];
+			t[i]->s1 = s1[i];
+			t[i]->distance = math< Traits >::real_max();
+			t[i]->load = loads[i];
+			math< Traits >::get_segment_bb(
+				s0[i], s1[i], t[i]->bbmin, t[i]->bbmax );
+		}
+
+		voxel_packet_traverser< real_type, vector_type, RAY_PACKET_SIZE > vt(
+			s0, s1, n, active_table_.gridsize() );
+
+		int x[RAY_PACKET_SIZE], y[RAY_PACKET_SIZE], z[RAY_PACKET_SIZE];
+		bool valid[RAY_PACKET_SIZE];
+		int scalar_lanes = n / 4 < 1 ? 1 : n / 4;
+		while( scalar_lanes < vt.active_count() ) {
+			vt.step_packet( x, y, z, valid );
+			for( int i = 0 ; i < n ; i++ ) {
+				if( !valid[i] ) { continue; }
+				size_t hv = active_table_.hash_value( x[i], y[i], z[i] );
+				active_table_.insert( hv, t[i] );
+			}
+		}
+
+		for( int i = 0 ; i < n ; i++ ) {
+			int cx, cy, cz;
+			while( vt.step_lane( i, cx, cy, cz ) ) {
+				size_t hv = active_table_.hash_value( cx, cy, cz );
+				active_table_.insert( hv, t[i] );
+			}
+		}
+	}
+
 	void add_triangle(
 		const vector_type& v0,
 		const vector_type& v1,
@@ -750,16 +898,75 @@ public:
 		}
 	}
 
+	// ZƂraypacketɂ܂Ƃ߂āAOp`1肷
+	//	 1{ray猩Op`̏Ԃ1{肷ƂƓ
 	template < class CallBack > 
 	void apply( const CallBack& c )
 	{
-		passive_table_.apply(
-			active_table_, InternalCallback< CallBack >( c ) );
+		real_type u[packet_size], v[packet_size], t[packet_size];
+
+		size_t n = passive_table_.tablesize();
+		for( size_t i = 0 ; i < n ; i++ ) {
+			typename passive_table_type::table_entry_type q0 =
+				passive_table_.entry( i );
+			typename active_table_type::table_entry_type p0 =
+				active_table_.entry( i );
+			if( !q0 || !p0 ) { continue; }
+
+			int batch_count = 0;
+			for( typename active_table_type::table_entry_type p = p0 ;
+				 p ;
+				 p = active_table_.next( p ) ) {
+				RayHashNode* rn = active_table_.unwrap( p );
+				if( batch_count == 0 ||
+					batches_[batch_count-1].packet.count == packet_size ) {
+					if( int( batches_.size() ) == batch_count ) {
+						batches_.push_back( RayBatch() );
+					}
+					Tester::clear( batches_[batch_count++].packet );
+				}
+				RayBatch& b = batches_[batch_count-1];
+				int k = Tester::add_ray( b.packet, rn->s0, rn->s1 );
+				b.bbmin[k] = rn->bbmin;
+				b.bbmax[k] = rn->bbmax;
+				b.nodes[k] = rn;
+			}
+
+			for( typename passive_table_type::table_entry_type q = q0 ;
+				 q ;
+				 q = passive_table_.next( q ) ) {
+				const TriangleHashNode* tn = passive_table_.unwrap( q );
+				for( int j = 0 ; j < batch_count ; j++ ) {
+					const RayBatch& b = batches_[j];
+
+					unsigned int mask = 0;
+					for( int k = 0 ; k < b.packet.count ; k++ ) {
+						if( math< Traits >::test_aabb_aabb(
+								b.bbmin[k], b.bbmax[k],
+								tn->bbmin, tn->bbmax ) ) {
+							mask |= 1u << k;
+						}
+					}
+					if( !mask ) { continue; }
+
+					mask &= Tester::test_rays(
+						b.packet, tn->v0, tn->v1, tn->v2, u, v, t );
+					for( int k = 0 ; k < b.packet.count ; k++ ) {
+						if( mask & ( 1u << k ) ) {
+							c( b.nodes[k]->load, tn->load,
+							   vector_traits::make_vector(
+								   u[k], v[k], t[k] ) );
+						}
+					}
+				}
+			}
+		}
 	}
 
 private:
-	IndirectSpatialHash< Traits, RayHashNode >  active_table_;
-	IndirectSpatialHash< Traits ,TriangleHashNode > passive_table_;
+	active_table_type			active_table_;
+	passive_table_type			passive_table_;
+	std::vector< RayBatch >		batches_;
 
 };
 
@@ -980,9 +1187,12 @@ private:
 	};
 
 public:
-	PointTetrahedronSpatialHash( real_type gridsize, int tablesize )
-		: active_table_( gridsize, tablesize ),
-		  passive_table_( gridsize, tablesize, "pt" )
+	PointTetrahedronSpatialHash(
+		real_type		gridsize,
+		int				tablesize,
+		page_arena&		arena = page_arena::instance() )
+		: active_table_( gridsize, tablesize, arena ),
+		  passive_table_( gridsize, tablesize, "pt", arena )
 	{
 	}
 	~PointTetrahedronSpatialHash()
@@ -1097,9 +1307,11 @@ private:
 };
 
 ////////////////////////////////////////////////////////////////
-// edge - face
+// edge / penetration - face
+//	 face1Xebv1񂾂o^A
+//	 border edgewEpenetration vectorŵꂼƓ˂킹
 template < class Traits >
-class EdgeFaceSpatialHash {
+class VolumeFaceSpatialHash {
 private:
 	typedef typename Traits::real_type      real_type;
 	typedef typename Traits::index_type     index_type;
@@ -1108,9 +1320,9 @@ private:
 	typedef Face< Traits >                  face_type;
 	typedef Edge< Traits >                  edge_type;
 	typedef TetrahedralMesh< Traits >       mesh_type;
-	typedef typename mesh_type::tetrahedron_type		tetrahedron_type;
-	typedef typename mesh_type::tetrahedra_type         tetrahedra_type;
-	typedef typename mesh_type::cloud_type::points_type points_type;
+	typedef typename mesh_type::tetrahedron_type            tetrahedron_type;
+	typedef typename mesh_type::tetrahedra_type             tetrahedra_type;
+	typedef typename mesh_type::cloud_type::points_type     points_type;
 
 	struct EdgeHashNode {
 		mesh_type*      mesh;
@@ -1118,6 +1330,10 @@ private:
 		vector_type     bbmin;
 		vector_type     bbmax;
 	};
+	struct PenetrationHashNode {
+		mesh_type*      mesh;
+		index_type      index;
+	};
 	struct FaceHashNode {
 		mesh_type*      mesh;
 		index_type      index;
@@ -1126,9 +1342,9 @@ private:
 	};
 
 	template < class T >
-	struct InternalCallback {
+	struct EdgeCallback {
 	public:
-		InternalCallback( const T& real_callback ) : c_( real_callback ) {}
+		EdgeCallback( const T& real_callback ) : c_( real_callback ) {}
 		bool operator()( const EdgeHashNode* p, const FaceHashNode* q ) const
 		{
 			if( p->mesh == q->mesh ) { return false; }
@@ -1176,150 +1392,10 @@ private:
 		const T& c_;
 	};
 
-public:
-	EdgeFaceSpatialHash(
-		real_type      gridsize,
-		int             tablesize )
-		: active_table_( gridsize, tablesize, "ef0" ),
-		  passive_table_( gridsize, tablesize, "ef1" )
-	{
-	}
-	~EdgeFaceSpatialHash()
-	{
-	}
-
-	void clear( real_type gridsize )
-	{
-		active_table_.clear( gridsize ); 
-		passive_table_.clear( gridsize ); 
-	}
-
-	void add_edge( mesh_type* p, index_type i )
-	{
-		const edge_type& e = p->get_edges()[i].indices;
-		const point_type& v0 = p->get_points()[e.i0];
-		const point_type& v1 = p->get_points()[e.i1];
-
-		EdgeHashNode* t = active_table_.alloc_node();
-		t->mesh = p;
-		t->index = i;
-		math< Traits >::get_segment_bb(
-			v0.new_position, v1.new_position, t->bbmin, t->bbmax );
-
-		voxel_traverser< real_type, vector_type > vt(
-			v0.new_position, v1.new_position, active_table_.gridsize() );
-
-		int x, y, z;
-		while( vt( x, y, z ) ) {
-			active_table_.insert( passive_table_.hash_value( x, y, z ), t );
-		}
-	}
-
-	void add_face( mesh_type* p, index_type i )
-	{
-		real_type gridsize = passive_table_.gridsize();
-
-		face_type& f = p->get_faces()[i];
-		points_type& points = p->get_points();
-		const vector_type& v0 = points[f.i0].new_position;
-		const vector_type& v1 = points[f.i1].new_position;
-		const vector_type& v2 = points[f.i2].new_position;
-
-		vector_type bbmin, bbmax;
-		math< Traits >::get_triangle_bb( v0, v1, v2, bbmin, bbmax );
-
-		int x0 = passive_table_.coord( bbmin.x );
-		int x1 = passive_table_.coord( bbmax.x );
-		int y0 = passive_table_.coord( bbmin.y );
-		int y1 = passive_table_.coord( bbmax.y );
-		int z0 = passive_table_.coord( bbmin.z );
-		int z1 = passive_table_.coord( bbmax.z );
-
-		vector_type n = math< Traits >::normalize(
-			math< Traits >::cross( v1 - v0, v2 - v0 ) );
-		real_type   d = math< Traits >::dot( n, v0 );
-
-		real_type e = gridsize * real_type( 0.5 );
-		real_type r = square( e ) * real_type( 3.0 ); // e*e + e*e + e*e
-
-		FaceHashNode* t = NULL;
-                
-		for( int z = z0 ; z <= z1 ; z++ ) {
-			for( int y = y0 ; y <= y1 ; y++ ) {
-				for( int x = x0 ; x <= x1; x++ ) {
-					size_t hv = passive_table_.hash_value( x, y, z );
-					if( !active_table_.entry( hv ) ) {
-						// optimize: active nodeȂƂł͏ȗ
-						continue;
-					}
-
-					// Z̒
-					vector_type c;
-					c.x = ( x + real_type( 0.5 ) ) * gridsize;
-					c.y = ( y + real_type( 0.5 ) ) * gridsize;
-					c.z = ( z + real_type( 0.5 ) ) * gridsize;
-
-					// plane - sphere(Z̑Ίp𒼌aƂ)ŃJO
-					real_type dist = math< Traits >::dot( c, n ) - d;
-					if( r < square( dist ) ) { continue; }
-
-					if( !t ) {
-						t = passive_table_.alloc_node();
-						t->mesh = p;
-						t->index = i;
-						t->bbmin = bbmin;
-						t->bbmax = bbmax;
-					}
-
-					passive_table_.insert( hv, t );
-				}
-			}
-		}
-	}
-
-	template < class Callback >
-	void apply( const Callback& c )
-	{
-		passive_table_.apply(
-			active_table_, InternalCallback< Callback >( c ) );
-	}
-
-private:
-	IndirectSpatialHash< Traits, EdgeHashNode >     active_table_;
-	IndirectSpatialHash< Traits ,FaceHashNode >     passive_table_;
-        
-
-};
-
-////////////////////////////////////////////////////////////////
-// penetration - face
-template < class Traits >
-class PenetrationFaceSpatialHash {
-private:
-	typedef typename Traits::real_type      real_type;
-	typedef typename Traits::index_type     index_type;
-	typedef typename Traits::vector_type    vector_type;
-	typedef Point< Traits >                 point_type;
-	typedef Face< Traits >                  face_type;
-	typedef Edge< Traits >                  edge_type;
-	typedef TetrahedralMesh< Traits >       mesh_type;
-	typedef typename mesh_type::tetrahedron_type            tetrahedron_type;
-	typedef typename mesh_type::tetrahedra_type             tetrahedra_type;
-	typedef typename mesh_type::cloud_type::points_type     points_type;
-
-	struct PenetrationHashNode {
-		mesh_type*      mesh;
-		index_type      index;
-	};
-	struct FaceHashNode {
-		mesh_type*      mesh;
-		index_type      index;
-	};
-
 	template < class T >
-	struct InternalCallback {
+	struct PenetrationCallback {
 	public:
-		InternalCallback( const T& real_callback ) : c_( real_callback ) {}
+		PenetrationCallback( const T& real_callback ) : c_( real_callback ) {}
 		bool operator()(
 			const PenetrationHashNode* p, const FaceHashNode* q ) const
 		{
@@ -1330,7 +1406,11 @@ private:
 
 			std::swap( uvt.x, uvt.y ); // \]Ă邩
 			c_( p->mesh, p->index, q->mesh, q->index, uvt );
-			return true;
+
+			// face̓JOAABB̑SZɓĂ̂ŁA
+			// ŏɓ̂ŋ߂Ƃ͌ȂBł؂炸ɑSnA
+			// ŋ߂̂̂World::add_contact(penetration_magnifier)Ŏc
+			return false;
 		}
 
 	private:
@@ -1356,29 +1436,54 @@ private:
 			return math< Traits >::test_ray_triangle( r0, r1, v0, v1,v2, uvt );
 		}
         
-        
 		const T& c_;
 	};
 
 public:
-	PenetrationFaceSpatialHash( real_type gridsize, int tablesize )
-		: active_table_( gridsize, tablesize, "pf0" ),
-		  passive_table_( gridsize, tablesize, "pf1" )
+	VolumeFaceSpatialHash(
+		real_type		gridsize,
+		int				tablesize,
+		page_arena&		arena = page_arena::instance() )
+		: edge_table_( gridsize, tablesize, "vf0", arena ),
+		  penetration_table_( gridsize, tablesize, "vf1", arena ),
+		  face_table_( gridsize, tablesize, "vf2", arena )
 	{
 	}
-	~PenetrationFaceSpatialHash()
+	~VolumeFaceSpatialHash()
 	{
 	}
 
 	void clear( real_type gridsize )
 	{
-		active_table_.clear( gridsize );
-		passive_table_.clear( gridsize );
+		edge_table_.clear( gridsize ); 
+		penetration_table_.clear( gridsize ); 
+		face_table_.clear( gridsize ); 
+	}
+
+	void add_edge( mesh_type* p, index_type i )
+	{
+		const edge_type& e = p->get_edges()[i].indices;
+		const point_type& v0 = p->get_points()[e.i0];
+		const point_type& v1 = p->get_points()[e.i1];
+
+		EdgeHashNode* t = edge_table_.alloc_node();
+		t->mesh = p;
+		t->index = i;
+		math< Traits >::get_segment_bb(
+			v0.new_position, v1.new_position, t->bbmin, t->bbmax );
+
+		voxel_traverser< real_type, vector_type > vt(
+			v0.new_position, v1.new_position, edge_table_.gridsize() );
+
+		int x, y, z;
+		while( vt( x, y, z ) ) {
+			edge_table_.insert( edge_table_.hash_value( x, y, z ), t );
+		}
 	}
 
 	void add_penetration( mesh_type* p, index_type i )
 	{
-		PenetrationHashNode* t = active_table_.alloc_node();
+		PenetrationHashNode* t = penetration_table_.alloc_node();
 		t->mesh = p;
 		t->index = i;
 
@@ -1390,7 +1495,7 @@ public:
 		// TODO: ̃R[hƈx
 		real_type slen = length( v.penetration_vector );
 		if( slen < math< Traits >::epsilon() ) { return; }
-		real_type len = slen + sqrt( square( active_table_.gridsize() ) * 3 );
+		real_type len = slen + sqrt( square( penetration_table_.gridsize() ) * 3 );
 
 		const vector_type& v0 = v.new_position;
 		vector_type v1 = v0 + v.penetration_vector * ( len / slen );
@@ -1400,15 +1505,18 @@ public:
 #endif
 
 		voxel_traverser< real_type, vector_type > vt(
-			v0, v1, active_table_.gridsize() );
+			v0, v1, penetration_table_.gridsize() );
 
 		int x, y, z;
 		while( vt( x, y, z ) ) {
-			size_t hv = active_table_.hash_value( x, y, z );
-			active_table_.insert( hv, t );
+			size_t hv = penetration_table_.hash_value( x, y, z );
+			penetration_table_.insert( hv, t );
 		}
 	}
 
+	// ǂ̑wƂ˂킹̂ŁAactive node̗Lł͏ȗȂ
+	//   (penetrationw͂̎_ł͂܂łĂȂ)
+	//   edge/faceAABBeXĝplane - sphereJOȂ
 	void add_face( mesh_type* p, index_type i )
 	{
 		const face_type& f = p->get_faces()[i];
@@ -1417,48 +1525,46 @@ public:
 		const vector_type& v1 = points[f.i1].new_position;
 		const vector_type& v2 = points[f.i2].new_position;
 
-		vector_type bbmin, bbmax;
-		math< Traits >::get_triangle_bb( v0, v1, v2, bbmin, bbmax );
-
-		int x0 = passive_table_.coord( bbmin.x );
-		int x1 = passive_table_.coord( bbmax.x );
-		int y0 = passive_table_.coord( bbmin.y );
-		int y1 = passive_table_.coord( bbmax.y );
-		int z0 = passive_table_.coord( bbmin.z );
-		int z1 = passive_table_.coord( bbmax.z );
+		FaceHashNode* t = face_table_.alloc_node();
+		t->mesh = p;
+		t->index = i;
+		math< Traits >::get_triangle_bb( v0, v1, v2, t->bbmin, t->bbmax );
 
-		FaceHashNode* t = NULL;
+		int x0 = face_table_.coord( t->bbmin.x );
+		int x1 = face_table_.coord( t->bbmax.x );
+		int y0 = face_table_.coord( t->bbmin.y );
+		int y1 = face_table_.coord( t->bbmax.y );
+		int z0 = face_table_.coord( t->bbmin.z );
+		int z1 = face_table_.coord( t->bbmax.z );
 
 		for( int z = z0 ; z <= z1 ; z++ ) {
 			for( int y = y0 ; y <= y1 ; y++ ) {
 				for( int x = x0 ; x <= x1; x++ ) {
-					size_t hv = passive_table_.hash_value( x, y, z );
-					if( !active_table_.entry( hv ) ) {
-						// optimize: active nodeȂƂł͏ȗ
-						continue; 
-					}
-
-					if( !t ) {
-						t = passive_table_.alloc_node();
-						t->mesh = p;
-						t->index = i;
-					}
-					passive_table_.insert( hv, t );
+					face_table_.insert(
+						face_table_.hash_value( x, y, z ), t );
 				}
 			}
 		}
 	}
 
 	template < class Callback >
-	void apply( const  Callback& c )
+	void apply_edges( const Callback& c )
 	{
-		passive_table_.apply(
-			active_table_, InternalCallback< Callback >( c ) );
+		face_table_.apply(
+			edge_table_, EdgeCallback< Callback >( c ) );
+	}
+
+	template < class Callback >
+	void apply_penetrations( const Callback& c )
+	{
+		face_table_.apply(
+			penetration_table_, PenetrationCallback< Callback >( c ) );
 	}
 
 private:
-	IndirectSpatialHash< Traits, PenetrationHashNode >      active_table_;
-	IndirectSpatialHash< Traits ,FaceHashNode >             passive_table_;
+	IndirectSpatialHash< Traits, EdgeHashNode >             edge_table_;
+	IndirectSpatialHash< Traits, PenetrationHashNode >      penetration_table_;
+	IndirectSpatialHash< Traits, FaceHashNode >             face_table_;
 
 };
 
@@ -1541,9 +1647,12 @@ private:
 	};
 
 public:
-	ClothPointTetrahedronSpatialHash( real_type gridsize, int tablesize )
-		: active_table_( gridsize, tablesize ),
-		  passive_table_( gridsize, tablesize, "cp1" )
+	ClothPointTetrahedronSpatialHash(
+		real_type		gridsize,
+		int				tablesize,
+		page_arena&		arena = page_arena::instance() )
+		: active_table_( gridsize, tablesize, arena ),
+		  passive_table_( gridsize, tablesize, "cp1", arena )
 	{
 	}
 	~ClothPointTetrahedronSpatialHash()
@@ -1744,9 +1853,10 @@ private:
 public:
 	ClothSpikeFaceSpatialHash(
 		real_type      gridsize,
-		int             tablesize )
-		: active_table_( gridsize, tablesize, "cs0" ),
-		  passive_table_( gridsize, tablesize, "cs1" )
+		int             tablesize,
+		page_arena&		arena = page_arena::instance() )
+		: active_table_( gridsize, tablesize, "cs0", arena ),
+		  passive_table_( gridsize, tablesize, "cs1", arena )
 	{
 	}
 	~ClothSpikeFaceSpatialHash()
@@ -1936,9 +2046,10 @@ private:
 public:
 	ClothEdgeFaceSpatialHash(
 		real_type      gridsize,
-		int             tablesize )
-		: active_table_( gridsize, tablesize, "ce0" ),
-		  passive_table_( gridsize, tablesize, "ce1" )
+		int             tablesize,
+		page_arena&		arena = page_arena::instance() )
+		: active_table_( gridsize, tablesize, "ce0", arena ),
+		  passive_table_( gridsize, tablesize, "ce1", arena )
 	{
 	}
 	~ClothEdgeFaceSpatialHash()
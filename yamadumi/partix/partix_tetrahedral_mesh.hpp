@@ -164,6 +164,20 @@ public:
 		return average_edge_length_;
 	}
 
+	// _Eg|WbV
+	//	 setupς݂̃bVɑ΂ČĂ(setup̃RXgȗł)
+	TetrahedralMesh* clone()
+	{
+		TetrahedralMesh* p = new TetrahedralMesh;
+		*p->cloud_				= *cloud_;
+		p->edges_				= edges_;
+		p->faces_				= faces_;
+		p->indices_				= indices_;
+		p->tetrahedra_			= tetrahedra_;
+		p->average_edge_length_ = average_edge_length_;
+		return p;
+	}
+
 	cloud_type*				get_cloud() { return cloud_; }
 	points_type&			get_points() { return cloud_->get_points(); }
 	edges_type&				get_edges() { return edges_; }
@@ -21,6 +21,7 @@
 #include "partix_plane.hpp"
 #include "partix_utilities.hpp"
 #include "performance_counter.hpp"
+#include "allocation_counter.hpp"
 #include <algorithm>
 
 namespace partix {
@@ -28,6 +29,11 @@ namespace partix {
 //const int SPATIAL_HASH_TABLE_SIZE = 4999;
 const int SPATIAL_HASH_TABLE_SIZE = 9997;
 const float SPATIAL_HASH_GRID_SIZE = 0.5f;
+const float SLEEPING_ISLAND_MARGIN = 0.05f;
+const int ADAPTIVE_TIMESTEP_GROW_STEPS = 8;
+const float SWEPT_COLLISION_MARGIN = SPATIAL_HASH_GRID_SIZE;
+const float SHAPE_RESIDUAL_TOLERANCE = 0.01f;
+const int RAYCAST_PACKET_SIZE = 8;
 
 template < class Traits >
 class Snapshot {
@@ -48,6 +54,7 @@ public:
              ++i ) {
             bodies_.push_back( (*i)->clone() );
         }
+        owners_ = ss.owners_;
         return *this;
     }
         
@@ -60,13 +67,46 @@ public:
             delete *i;
         }
         bodies_.clear();
+        owners_.clear();
     }
 
-    void add( BodySnapShot< Traits >* b ) { bodies_.push_back( b ); }
+    void add( BodySnapShot< Traits >* b, Body< Traits >* owner )
+    {
+        bodies_.push_back( b );
+        owners_.push_back( owner );
+    }
+
+    // iԖڂowneř݂̏Ԃɂ
+    //   OƓownerȂ㏑̂Ŋ蓖Ă͋NȂ
+    void store( int i, Body< Traits >* owner )
+    {
+        if( i == int( bodies_.size() ) ) {
+            add( owner->make_snapshot(), owner );
+        } else if( owners_[i] == owner ) {
+            owner->store_snapshot( bodies_[i] );
+        } else {
+            delete bodies_[i];
+            bodies_[i] = owner->make_snapshot();
+            owners_[i] = owner;
+        }
+    }
+
+    // n̂Ă
+    void truncate( int n )
+    {
+        while( n < int( bodies_.size() ) ) {
+            delete bodies_.back();
+            bodies_.pop_back();
+            owners_.pop_back();
+        }
+    }
 
 private:
     bodies_type bodies_;
 
+    // World::bodies_̏sleep/wakeŕς̂ŁAΉbodyoĂ
+    std::vector< Body< Traits >* > owners_;
+
     template < class T > friend class World;
 };
 
@@ -103,8 +143,20 @@ public:
     typedef std::vector< collidable_type* >         collidables_type;
     typedef std::vector< constraint_type >          constraints_type;
     typedef std::vector< contact_type* >            contacts_type;
+    typedef ContactCache< Traits >                  contact_cache_type;
+    typedef typename contact_cache_type::entry_type contact_cache_entry_type;
     typedef aabb_tree< Traits, collidable_type* >   aabb_tree_type;
 
+    typedef frame_allocator< arena_page_provider >  scratch_allocator_type;
+    typedef std::vector<
+        softvolume_type*,
+        frame_stl_allocator< softvolume_type*, scratch_allocator_type > >
+                                                    scratch_softvolumes_type;
+    typedef std::vector<
+        cloth_type*,
+        frame_stl_allocator< cloth_type*, scratch_allocator_type > >
+                                                    scratch_clothes_type;
+
     typedef RayProcessor< Traits >                  ray_processor_type;
     typedef typename ray_processor_type::triangle_slot triangle_slot;
     typedef typename ray_processor_type::ray_slot      ray_slot;
@@ -117,31 +169,101 @@ public:
         bool operator()( body_type* ) const { return true; }
     };
 
+    // raycast
+    //   s0s1܂ł̐ŒׂBdistances00As11Ƃʒu
+    struct raycast_ray {
+        vector_type         s0;
+        vector_type         s1;
+    };
+    struct raycast_result {
+        body_type*          body;       // ȂNULL
+        real_type           distance;
+    };
+    enum raycast_mode {
+        RAYCAST_CLOSEST,    // ԋ߂
+        RAYCAST_ANY         // ǂꂩ1(ʂȂ)
+    };
+    struct nofilter_ray {
+    public:
+        bool operator()( int, body_type* ) const { return true; }
+    };
+
+    // query_frustump6̕(@͓)
+    struct frustum_type {
+        vector_type         positions[6];
+        vector_type         normals[6];
+    };
+
+    // Ăisland
+    //   obodies_OAt[̏̑ΏۂɂȂȂ
+    struct island_type {
+        vector_type     bbmin;
+        vector_type     bbmax;
+        bodies_type     bodies;
+    };
+    typedef std::vector< island_type >              islands_type;
+
+    // static treeɓĂcollidable
+    //   gAABBςƂ蒼
+    struct static_entry_type {
+        collidable_type*    collidable;
+        vector_type         bbmin;
+        vector_type         bbmax;
+    };
+    typedef std::vector< static_entry_type >        static_entries_type;
+
+    // ʂƂ̐
+    //   pointƂɖ@ƈʒuRs[A(body, plane)̑gƂ
+    //   plane_points_[begin, end)
+    struct plane_constraint_type {
+        body_type*          A_body;
+        plane_type*         plane;
+        int                 begin;
+        int                 end;
+    };
+    typedef std::vector< plane_constraint_type >    plane_constraints_type;
+    typedef std::vector< point_type* >              plane_points_type;
+
 public:
     World()
-        : contact_pool_( page_provider_, "contact" ),
+        : page_provider_( arena_ ),
+          contact_pool_( page_provider_, "contact" ),
+          scratch_( page_provider_ ),
+          aabbt_( arena_ ),
+          static_aabbt_( arena_ ),
 		  ray_processor_( 
             SPATIAL_HASH_GRID_SIZE,
-            SPATIAL_HASH_TABLE_SIZE ),
+            SPATIAL_HASH_TABLE_SIZE,
+            arena_ ),
           point_tetrahedron_spatial_hash_(
               SPATIAL_HASH_GRID_SIZE,
-              SPATIAL_HASH_TABLE_SIZE ),
-          edge_face_spatial_hash_(
+              SPATIAL_HASH_TABLE_SIZE,
+              arena_ ),
+          volume_face_spatial_hash_(
               SPATIAL_HASH_GRID_SIZE,
-              SPATIAL_HASH_TABLE_SIZE ),
-          penetration_face_spatial_hash_(
-              SPATIAL_HASH_GRID_SIZE,
-              SPATIAL_HASH_TABLE_SIZE ),
+              SPATIAL_HASH_TABLE_SIZE,
+              arena_ ),
           cloth_point_tetrahedron_spatial_hash_(
               SPATIAL_HASH_GRID_SIZE,
-              SPATIAL_HASH_TABLE_SIZE ),
+              SPATIAL_HASH_TABLE_SIZE,
+              arena_ ),
           cloth_spike_face_spatial_hash_(
               SPATIAL_HASH_GRID_SIZE,
-              SPATIAL_HASH_TABLE_SIZE ),
+              SPATIAL_HASH_TABLE_SIZE,
+              arena_ ),
           cloth_edge_face_spatial_hash_(
               SPATIAL_HASH_GRID_SIZE,
-              SPATIAL_HASH_TABLE_SIZE ) {
+              SPATIAL_HASH_TABLE_SIZE,
+              arena_ ) {
         body_id_seed_ = 0;
+        step_allocation_count_ = 0;
+        contact_cache_hit_count_ = 0;
+        contact_cache_enabled_ = false;
+        contact_reduction_cap_ = 0;
+        contact_count_before_reduction_ = 0;
+        swept_collision_ = false;
+        query_tree_dirty_ = true;
+        query_island_count_ = 0;
         init();
     }
     ~World() {}
@@ -155,6 +277,15 @@ public:
         remove_body_internal( p );
     }
 
+    // Worldɓꂽ܂bodỹbVւ(PrefabLOD؂ւp)
+    //   remove_body/add_bodyƈႢAidEslotEĂisland͂̂܂܂ŁA
+    //   ڐGLbVbodŷ̕ĂȂ
+    template < class Volume >
+    void set_body_mesh( Volume* v, typename Volume::mesh_type* m )
+    {
+        set_body_mesh_internal( v, m );
+    }
+
     void save_snapshot( Snapshot< Traits >& snapshot )
     {
         save_snapshot_internal( snapshot );
@@ -173,11 +304,90 @@ public:
         update_internal( elapsed );
     }
 
+    // Œ^CXebv
+    //   advanceɓnꂽoߎԂ𒙂߂ĂAstep݂updateB
+    //   1advanceŉ񂷂̂max_substeps܂(ȏ̒x͎̂Ă)
+    void set_fixed_timestep( real_type step, int max_substeps )
+    {
+        assert( epsilon() <= step );
+        assert( 0 < max_substeps );
+        fixed_timestep_ = step;
+        max_substeps_ = max_substeps;
+        accumulator_ = 0;
+        interpolation_alpha_ = 1;
+    }
+    real_type get_fixed_timestep() { return fixed_timestep_; }
+    int get_max_substeps() { return max_substeps_; }
+
+    // ߂l͎sXebv
+    int advance( real_type elapsed )
+    {
+        return advance_internal( elapsed );
+    }
+
+    // `p̕ԌW
+    //   ÕXebv̊Jn_(0)I_(1)̂ǂ\ׂ
+    //   SoftVolume::get_interpolated_deformed_matrixɓn
+    real_type get_interpolation_alpha() { return interpolation_alpha_; }
+
+    // max_substeps𒴂߂Ɏ̂ĂԂ̗݌v
+    real_type get_dropped_time() { return dropped_time_; }
+
+    // σ^CXebv(advanceł̂ݗL)
+    //   Xebv̂߂荞ݗ(contact̉oʂ̍ő)
+    //   ό`(Body::get_distortion()̍ő)l𒴂A
+    //   XebvOSnapshotɊ߂č݂𔼕ɂĂ蒼B
+    //   ĂԂ͍݂max_step܂ŏXɐL΂B
+    //   ߂pɖXebvSnapshot̂ł̕͏dȂ
+    //   (bodyƂ̃obt@ɏ㏑̂ŁA蓖Ă͋NȂ)
+    void set_adaptive_timestep(
+        bool enable, real_type min_step, real_type max_step )
+    {
+        assert( epsilon() <= min_step && min_step <= max_step );
+        adaptive_timestep_ = enable;
+        min_timestep_ = min_step;
+        max_timestep_ = max_step;
+        current_timestep_ = fixed_timestep_;
+        if( current_timestep_ < min_step ) { current_timestep_ = min_step; }
+        if( max_step < current_timestep_ ) { current_timestep_ = max_step; }
+        calm_steps_ = 0;
+    }
+    void set_adaptive_thresholds(
+        real_type max_penetration, real_type max_distortion )
+    {
+        max_penetration_ = max_penetration;
+        max_distortion_ = max_distortion;
+    }
+    bool get_adaptive_timestep() { return adaptive_timestep_; }
+
+    // advanceŎg
+    real_type get_current_timestep()
+    {
+        return adaptive_timestep_ ? current_timestep_ : fixed_timestep_;
+    }
+    // ߂Ă蒼񐔂̗݌v
+    int get_rollback_count() { return rollback_count_; }
+
     void set_global_force( const vector_type& g )
     {
         set_global_force_internal( g );
     }
 
+    // ĂislandׂċN
+    void wake_all()
+    {
+        wake_all_internal();
+    }
+
+    // pĂ΁Ap܂islandN
+    //   ĂbodyO璼ړ(teleport, set_frozen,
+    //   set_global_forceȂ)Ƃ͐ɌĂԂ
+    void wake_body( body_type* p )
+    {
+        wake_body_internal( p );
+    }
+    int get_sleeping_island_count() { return int( islands_.size() ); }
+
     body_type* pick( const vector_type& s0, const vector_type& s1 )
     {
         return pick_internal( s0, s1, nofilter(), NULL );
@@ -199,9 +409,129 @@ public:
     {
         return pick_internal( s0, s1, f, &distance );
     }
+
+    // ̈ƏdȂcollidable񋓂
+    //   c( collidable )dȂcollidableƂɌĂ΂(bodyget_body())B
+    //   broad phaseAABB treeŔ肷̂ŁAAABBm̏dȂłȂB
+    //   updatěAbodyoꂷ܂ł̓q[v蓖ĂA
+    //   ǂނȂ̂ŕXbh瓯ɌĂł悢
+    //   (updateƓɌĂł͂Ȃ)
+    template < class Callback >
+    void query_aabb( const vector_type& bbmin, const vector_type& bbmax,
+                     const Callback& c )
+    {
+        aabb_query_visitor< Callback > v( bbmin, bbmax, c );
+        query_internal( v );
+    }
+    template < class Callback >
+    void query_sphere( const vector_type& center, real_type radius,
+                       const Callback& c )
+    {
+        sphere_query_visitor< Callback > v( center, radius, c );
+        query_internal( v );
+    }
+    template < class Callback >
+    void query_frustum( const frustum_type& frustum, const Callback& c )
+    {
+        frustum_query_visitor< Callback > v( frustum, c );
+        query_internal( v );
+    }
+
+    // ܂Ƃ߂raycast
+    //   broad phaseAABB treeRAYCAST_PACKET_SIZE{ǂB
+    //   filterf( rayindex, body )falseԂƂbody𖳎B
+    //   ebodyƂ̔(Collidable::pick)X^bNゾōŝŁA
+    //   query_aabbȂǂƓXbh瓯ɌĂł悢
+    //   (updateƓɌĂł͂Ȃ)
+    void raycast( const raycast_ray* rays, raycast_result* results, int n,
+                  raycast_mode mode = RAYCAST_CLOSEST )
+    {
+        nofilter_ray f;
+        raycast_internal( rays, results, n, mode, f );
+    }
+    template < class Filter >
+    void raycast_filter( const raycast_ray* rays, raycast_result* results,
+                         int n, raycast_mode mode, Filter f )
+    {
+        raycast_internal( rays, results, n, mode, f );
+    }
         
     real_type get_time() { return time_; } 
 
+    // fixed_pool̃y[Wgp
+    //   WorldƂɕʂpage_arena̂ŁA
+    //   ʁXWorld͕ʁX̃XbhœĂ悢
+    void get_memory_stats( page_arena::stats_type& stats )
+    {
+        page_provider_.get_arena().get_stats( stats );
+    }
+    // ׂ̃s[NȂǂɁA󂢂y[W
+    size_t trim_memory()
+    {
+        scratch_.release();
+        return page_provider_.get_arena().trim();
+    }
+
+    // Oupdateł̃O[ooperator new̌Ăяo
+    //  (allocation_counter.hpp̃JE^LɂƂ̂)
+    size_t get_step_allocation_count() { return step_allocation_count_; }
+
+    // contact̊Ԉ
+    //   (A_body, B_body)̑gƂcontactcap܂łɂB0ȂԈȂ
+    void set_contact_reduction( int cap )
+    {
+        assert( 0 <= cap );
+        contact_reduction_cap_ = cap;
+    }
+    int get_contact_reduction() { return contact_reduction_cap_; }
+
+    // swept collision
+    //   _old_position\ʒu܂łrayŒׁA
+    //   ܂͂ĂȂ/ʂƂ͑x𐧌鐧(speculative)
+    void set_swept_collision( bool f )
+    {
+        swept_collision_ = f;
+        ray_processor_.set_swept( f );
+    }
+    bool get_swept_collision() { return swept_collision_; }
+
+    // `󕜌̔
+    //   match_shape/restore_shape1XebvɍőnJԂB
+    //   ڕWʒû(Body::get_shape_residual)tolerance
+    //   Ȃbody͂őł؂
+    void set_shape_iterations(
+        int n, real_type tolerance = SHAPE_RESIDUAL_TOLERANCE )
+    {
+        assert( 1 <= n );
+        assert( 0 <= tolerance );
+        shape_iterations_ = n;
+        shape_tolerance_ = tolerance;
+    }
+    int get_shape_iterations() { return shape_iterations_; }
+    real_type get_shape_tolerance() { return shape_tolerance_; }
+
+    // OupdatełbodyƂ̔񐔂̍ől
+    int get_shape_iteration_count() { return shape_iteration_count_; }
+
+    // OupdateŊԈOƌcontact̐
+    int get_collected_contact_count()
+    {
+        return contact_count_before_reduction_;
+    }
+    int get_reduced_contact_count() { return int( contacts_.size() ); }
+
+    // Ot[contactoĂAʂɂ܂hĂ_
+    // ̖ʂŋ߂̌ƂČn߂(ContactCache)BftHgoff
+    void set_contact_cache( bool f )
+    {
+        contact_cache_enabled_ = f;
+        contact_cache_.clear();
+    }
+    bool get_contact_cache() { return contact_cache_enabled_; }
+
+    // OupdateContactCache̖ʂlɂcontact̐
+    int get_contact_cache_hit_count() { return contact_cache_hit_count_; }
+
     void dump()
     {
         for( typename bodies_type::const_iterator i = bodies_.begin() ;
@@ -217,50 +547,125 @@ private:
         make_collision_resolver_table();
         time_ = 0;
 		previous_idt_ = real_type( 1 ) / Traits::tick();
+        fixed_timestep_ = Traits::tick();
+        max_substeps_ = 4;
+        accumulator_ = 0;
+        interpolation_alpha_ = 1;
+        dropped_time_ = 0;
+        adaptive_timestep_ = false;
+        min_timestep_ = max_timestep_ = current_timestep_ = Traits::tick();
+        max_penetration_ = SPATIAL_HASH_GRID_SIZE * 2.0f;
+        max_distortion_ = 0.5f;
+        calm_steps_ = 0;
+        rollback_count_ = 0;
+        shape_iterations_ = 1;
+        shape_tolerance_ = SHAPE_RESIDUAL_TOLERANCE;
+        shape_iteration_count_ = 0;
     }
 
     void add_body_internal( body_type* p )
     {
         p->set_id( body_id_seed_++ );
+        p->set_slot( int( bodies_.size() ) );
         bodies_.push_back( p ); 
+        query_tree_dirty_ = true;
+
+        // ĂislandƂ̏dȂ蔻Ɏĝ
+        p->update_boundingbox();
     }                
 
     void remove_body_internal( body_type* p )
     {
-        bodies_.erase(
-            std::find(
-                bodies_.begin(),
-                bodies_.end(),
-                p ) );
+        wake_body_internal( p );
+
+        // Point̃AhXɂȂ̂
+        contact_cache_.remove_body( p );
+        query_tree_dirty_ = true;
+
+        // ߂psnapshotg񂹂ȂȂ
+        rollback_.clear();
+
+        remove_body_slot( p );
+    }                
+
+    template < class Volume >
+    void set_body_mesh_internal( Volume* v, typename Volume::mesh_type* m )
+    {
+        // ÂPointwĂ̂
+        contact_cache_.remove_body( v );
+        query_tree_dirty_ = true;
+
+        v->set_mesh( m );
+        v->regularize();
+        v->update_boundingbox();
+
+        // Ăisland́ANɎgAABBLĂ
+        //   (rollback_̓XebvƂstorêł̂܂܂ł悢)
+        if( 0 <= v->get_island() ) {
+            island_type& island = islands_[v->get_island()];
+            collidables_type& S = sleep_S_;
+            S.clear();
+            v->list_collision_units( S );
+            for( typename collidables_type::const_iterator j = S.begin() ;
+                 j != S.end() ;
+                 ++j ) {
+                math< Traits >::update_bb(
+                    island.bbmin, island.bbmax, (*j)->get_bbmin() );
+                math< Traits >::update_bb(
+                    island.bbmin, island.bbmax, (*j)->get_bbmax() );
+            }
+        }
+    }
+
+    // body󂢂slotɈڂbodies_O(O(1))
+    //   点ƂPointtreê܂܎ĝŁAꂾs
+    void remove_body_slot( body_type* p )
+    {
+        int slot = p->get_slot();
+        assert( 0 <= slot && slot < int( bodies_.size() ) );
+        assert( bodies_[slot] == p );
+
+        body_type* q = bodies_.back();
+        bodies_[slot] = q;
+        q->set_slot( slot );
+        bodies_.pop_back();
+        p->set_slot( -1 );
     }                
 
     void save_snapshot_internal( Snapshot< Traits >& snapshot )
     {
         // LSnapShotɈړ
 
+        wake_all_internal();
+
         snapshot.clear();
         for( typename bodies_type::const_iterator i = bodies_.begin() ;
              i != bodies_.end() ;
              ++i ) {
-            snapshot.add( (*i)->make_snapshot() );
+            snapshot.add( (*i)->make_snapshot(), *i );
         }
     }
 
     void load_snapshot_internal( const Snapshot< Traits >& snapshot )
     {
-        int ii = 0;
-        for( typename bodies_type::const_iterator i = bodies_.begin() ;
-             i != bodies_.end() ;
-             ++i ) {
-            const BodySnapShot< Traits >* es =
-                snapshot.bodies_[ii++];
-                        
-            (*i)->apply_snapshot( es );
+        wake_all_internal();
+        apply_snapshot_internal( snapshot );
+    }
+
+    void apply_snapshot_internal( const Snapshot< Traits >& snapshot )
+    {
+        query_tree_dirty_ = true;
+
+        int n = int( snapshot.bodies_.size() );
+        for( int i = 0 ; i < n ; i++ ) {
+            snapshot.owners_[i]->apply_snapshot( snapshot.bodies_[i] );
         }
     }
 
     void restart_internal()
     { 
+        wake_all_internal();
+        query_tree_dirty_ = true;
         for( typename bodies_type::const_iterator i = bodies_.begin() ;
              i != bodies_.end() ;
              ++i ) {
@@ -276,6 +681,8 @@ private:
 
         time_ += elapsed;
 
+        size_t allocation_base = allocation_counter();
+
         // WARNING:
         // ȉ̏̏肷ɂāA
         // ȉ̏Kv
@@ -287,6 +694,9 @@ private:
         PerformanceCounter pc( false );
         pc.print( "update0" );
 
+        // ĂbodydȂĂislandN
+        wake_touched_islands();
+
         begin_frame();
         debug_check();
         pc.print( "update1" );
@@ -301,7 +711,10 @@ private:
         debug_check();
         pc.print( "update4" );
 
-        restore_shape( dt, idt, 0 );
+        restore_shape( dt, idt, shape_iterations_ - 1 );
+        debug_check();
+
+        iterate_shape( dt, idt );
         debug_check();
         pc.print( "update5" );
 
@@ -342,11 +755,130 @@ private:
         debug_check();
         pc.print( "update14" );
 
+        // island𖰂点
+        fall_asleep();
+        pc.print( "update15" );
+
+        // ₢킹ptreeAABBend_framě̂̂ɂ
+        refit_query_trees();
+        pc.print( "update16" );
+
 		previous_idt_ = idt;
+
+        step_allocation_count_ = allocation_counter() - allocation_base;
+    }
+
+    int advance_internal( real_type elapsed )
+    {
+        if( elapsed < 0 ) { elapsed = 0; }
+        accumulator_ += elapsed;
+
+        int n = 0;
+        real_type step = get_current_timestep();
+        while( step <= accumulator_ && n < max_substeps_ ) {
+            if( adaptive_timestep_ ) {
+                accumulator_ -= adaptive_step();
+            } else {
+                update_internal( step );
+                accumulator_ -= step;
+            }
+            step = get_current_timestep();
+            n++;
+        }
+
+        // ǂȂ͎̂Ă(̓X[[VɂȂ)
+        if( step <= accumulator_ ) {
+            real_type rest = fmod( accumulator_, step );
+            dropped_time_ += accumulator_ - rest;
+            accumulator_ = rest;
+        }
+        if( accumulator_ < 0 ) { accumulator_ = 0; }
+
+        interpolation_alpha_ = accumulator_ / step;
+        return n;
+    }
+
+    real_type adaptive_step()
+    {
+        // ߂̑ΏۂɊ܂܂悤AG閰island͐ɋN
+        wake_touched_islands();
+
+        for(;;) {
+            real_type dt = current_timestep_;
+            real_type time = time_;
+            real_type previous_idt = previous_idt_;
+
+            // bodies_̕тOƓȂBodySnapShotg
+            int n = int( bodies_.size() );
+            for( int i = 0 ; i < n ; i++ ) {
+                rollback_.store( i, bodies_[i] );
+            }
+            rollback_.truncate( n );
+
+            // island͂̃Xebvfall_asleepŖ
+            int island_count = int( islands_.size() );
+
+            update_internal( dt );
+
+            real_type penetration = 0;
+            for( typename contacts_type::const_iterator i =
+                     contacts_.begin() ;
+                 i != contacts_.end() ;
+                 ++i ) {
+                real_type l = length( (*i)->A_point->active_contact_pushout );
+                if( penetration < l ) { penetration = l; }
+            }
+            real_type distortion = 0;
+            for( typename bodies_type::const_iterator i = bodies_.begin() ;
+                 i != bodies_.end() ;
+                 ++i ) {
+                real_type d = (*i)->get_distortion();
+                if( distortion < d ) { distortion = d; }
+            }
+
+            bool failed =
+                max_penetration_ < penetration ||
+                max_distortion_ < distortion;
+            if( failed && min_timestep_ < dt ) {
+                // XebvOɖ߂č݂k߂
+                //   N̂͂̃XebvŖisland
+                //   (XebvO疰Ă̂rollback_ɓĂȂ)
+                while( island_count < int( islands_.size() ) ) {
+                    wake_island( int( islands_.size() ) - 1 );
+                }
+                apply_snapshot_internal( rollback_ );
+                contact_cache_.unflip();
+                time_ = time;
+                previous_idt_ = previous_idt;
+
+                current_timestep_ = dt * real_type( 0.5 );
+                if( current_timestep_ < min_timestep_ ) {
+                    current_timestep_ = min_timestep_;
+                }
+                calm_steps_ = 0;
+                rollback_count_++;
+                continue;
+            }
+
+            if( penetration < max_penetration_ * real_type( 0.25 ) &&
+                distortion < max_distortion_ * real_type( 0.25 ) ) {
+                if( ADAPTIVE_TIMESTEP_GROW_STEPS <= ++calm_steps_ ) {
+                    current_timestep_ = dt * real_type( 1.25 );
+                    if( max_timestep_ < current_timestep_ ) {
+                        current_timestep_ = max_timestep_;
+                    }
+                    calm_steps_ = 0;
+                }
+            } else {
+                calm_steps_ = 0;
+            }
+            return dt;
+        }
     }
 
     void set_global_force_internal( const vector_type& g )
     {
+        wake_all_internal();
         for( typename bodies_type::const_iterator i = bodies_.begin() ;
              i != bodies_.end() ;
              ++i ) {
@@ -355,51 +887,414 @@ private:
         }
     }
 
-    template < class InnerTraits >
-    class picker {
+    template < class Filter >
+    class pick_filter_adapter {
     public:
-        picker( std::vector< Collidable< InnerTraits >* >& c ) : c_( c ) {} 
-        void operator()( Collidable< InnerTraits >* y ) const { c_.push_back( y ); }
+        pick_filter_adapter( Filter& f ) : f_( f ) {}
+        bool operator()( int, body_type* b ) const { return f_( b ); }
     private:
-        std::vector< Collidable< InnerTraits >* >& c_;
+        Filter& f_;
     };
 
     template < class Filter >
     body_type* pick_internal( const vector_type& s0, const vector_type& s1,
                               Filter filter, real_type* distance )
     {
-        collidables_type S;
-        for( typename bodies_type::const_iterator i = bodies_.begin() ;
-             i != bodies_.end() ;
-             ++i ) {
-            (*i)->list_collision_units( S );
+        raycast_ray ray;
+        ray.s0 = s0;
+        ray.s1 = s1;
+        raycast_result result;
+        pick_filter_adapter< Filter > f( filter );
+        raycast_internal( &ray, &result, 1, RAYCAST_CLOSEST, f );
+
+        if( result.body && distance ) { *distance = result.distance; }
+        return result.body;
+    }
+
+    // RAYCAST_PACKET_SIZE{ray܂Ƃ߂AABB treeǂ
+    //   state_type͂܂肤raỹrbg}XNB
+    //   ray͎Ƃɕׂ(SoA)AƂslab test
+    //   RAYCAST_PACKET_SIZE{𕪊Ȃňxɍs
+    template < class Filter >
+    class raycast_visitor {
+    public:
+        typedef unsigned int state_type;
+
+        raycast_visitor(
+            World< Traits >*        w,
+            const raycast_ray*      rays,
+            raycast_result*         results,
+            int                     base,
+            int                     n,
+            raycast_mode            mode,
+            Filter&                 filter )
+            : w_( w ), rays_( rays ), results_( results ), base_( base ),
+              n_( n ), mode_( mode ), filter_( filter )
+        {
+            assert( n <= RAYCAST_PACKET_SIZE );
+            for( int i = 0 ; i < RAYCAST_PACKET_SIZE ; i++ ) {
+                if( n <= i ) {
+                    // 󂫃[͂ǂ̔ɂȂ(limit)
+                    for( int axis = 0 ; axis < 3 ; axis++ ) {
+                        set_axis( i, axis, 0, 0 );
+                    }
+                    continue;
+                }
+                const vector_type& s0 = rays[i].s0;
+                vector_type d = rays[i].s1 - s0;
+                set_axis( i, 0, s0.x, d.x );
+                set_axis( i, 1, s0.y, d.y );
+                set_axis( i, 2, s0.z, d.z );
+            }
         }
 
-        collidable_type* found = NULL;
+        state_type all() const { return ( 1u << n_ ) - 1; }
 
-        real_type min_dist = math< Traits >::real_max();
-        for( typename collidables_type::const_iterator i = S.begin() ;
-             i != S.end() ;
-             ++i ) {
-            collidable_type* b = *i;
-            if( !filter( b->get_body() ) ) { continue; }
-
-            real_type dist;
-            if( math< Traits >::test_aabb_segment(
-                    b->get_bbmin(), b->get_bbmax(), s0, s1 )  &&
-                b->pick( s0, s1, dist ) ) {
-                if( dist < min_dist ) {
-                    min_dist = dist;
-                    found = b;
+        bool enter( const vector_type& bbmin, const vector_type& bbmax,
+                    state_type s, state_type& t ) const
+        {
+            const real_type mn[3] = { bbmin.x, bbmin.y, bbmin.z };
+            const real_type mx[3] = { bbmax.x, bbmax.y, bbmax.z };
+            const real_type big = math< Traits >::real_max();
+
+            real_type tmin[RAYCAST_PACKET_SIZE];
+            real_type tmax[RAYCAST_PACKET_SIZE];
+            for( int i = 0 ; i < RAYCAST_PACKET_SIZE ; i++ ) {
+                tmin[i] = 0;
+                tmax[i] = limit( i );
+            }
+
+            for( int axis = 0 ; axis < 3 ; axis++ ) {
+                const real_type* o = origin_[axis];
+                const real_type* inv = inverse_[axis];
+                const bool* par = parallel_[axis];
+                for( int i = 0 ; i < RAYCAST_PACKET_SIZE ; i++ ) {
+                    real_type t0 = ( mn[axis] - o[i] ) * inv[i];
+                    real_type t1 = ( mx[axis] - o[i] ) * inv[i];
+                    real_type lo = t0 < t1 ? t0 : t1;
+                    real_type hi = t0 < t1 ? t1 : t0;
+
+                    // ɕsrayslab̒Ȃ琧ȂAOȂ
+                    bool inside = mn[axis] <= o[i] && o[i] <= mx[axis];
+                    lo = par[i] ? ( inside ? -big : big ) : lo;
+                    hi = par[i] ? ( inside ? big : -big ) : hi;
+
+                    tmin[i] = tmin[i] < lo ? lo : tmin[i];
+                    tmax[i] = hi < tmax[i] ? hi : tmax[i];
+                }
+            }
+
+            t = 0;
+            for( int i = 0 ; i < n_ ; i++ ) {
+                if( ( s & ( 1u << i ) ) && tmin[i] <= tmax[i] ) {
+                    t |= 1u << i;
+                }
+            }
+            return t != 0;
+        }
+
+        void leaf( collidable_type* c, state_type s ) const
+        {
+            for( int i = 0 ; i < n_ ; i++ ) {
+                if( !( s & ( 1u << i ) ) ) { continue; }
+                w_->raycast_collidable(
+                    rays_[i], results_[i], base_ + i, mode_, c, filter_ );
+            }
+        }
+
+    private:
+        void set_axis( int i, int axis, real_type s0, real_type d )
+        {
+            origin_[axis][i] = s0;
+            parallel_[axis][i] = std::abs( d ) < math< Traits >::epsilon();
+            inverse_[axis][i] =
+                parallel_[axis][i] ? real_type( 0 ) : real_type( 1 ) / d;
+        }
+
+        // raỹp[^̏
+        //   ɌĂ̂艓ׂ͒ȂĂ悢B
+        //   Ȃ(ANYŌA󂫃[)ǂׂ̔Ȃ
+        real_type limit( int i ) const
+        {
+            if( n_ <= i ) { return -1; }
+            const raycast_result& r = results_[i];
+            if( !r.body ) { return 1; }
+            return mode_ == RAYCAST_ANY ? real_type( -1 ) : r.distance;
+        }
+
+    private:
+        World< Traits >*        w_;
+        const raycast_ray*      rays_;
+        raycast_result*         results_;
+        int                     base_;
+        int                     n_;
+        raycast_mode            mode_;
+        Filter&                 filter_;
+        real_type               origin_[3][RAYCAST_PACKET_SIZE];
+        real_type               inverse_[3][RAYCAST_PACKET_SIZE];
+        bool                    parallel_[3][RAYCAST_PACKET_SIZE];
+    };
+    template < class T > friend class raycast_visitor;
+
+    template < class Filter >
+    void raycast_collidable(
+        const raycast_ray&  ray,
+        raycast_result&     result,
+        int                 index,
+        raycast_mode        mode,
+        collidable_type*    c,
+        Filter&             filter )
+    {
+        if( result.body && mode == RAYCAST_ANY ) { return; }
+
+        body_type* b = c->get_body();
+        if( !filter( index, b ) ) { return; }
+
+        real_type dist;
+        if( !math< Traits >::test_aabb_segment(
+                c->get_bbmin(), c->get_bbmax(), ray.s0, ray.s1 ) ||
+            !c->pick( ray.s0, ray.s1, dist ) ) {
+            return;
+        }
+        if( result.body && result.distance <= dist ) { return; }
+
+        result.body = b;
+        result.distance = dist;
+    }
+
+    template < class Filter >
+    void raycast_internal(
+        const raycast_ray*  rays,
+        raycast_result*     results,
+        int                 n,
+        raycast_mode        mode,
+        Filter&             filter )
+    {
+        for( int i = 0 ; i < n ; i++ ) {
+            results[i].body = NULL;
+            results[i].distance = math< Traits >::real_max();
+        }
+
+        if( query_tree_dirty_ ) {
+            // body̏o肪Ă܂treeĂȂ̂ő
+            // (query_internalƓȀꍇ͊蓖ĂN肤)
+            collidables_type S;
+            list_all_collision_units( S );
+            for( typename collidables_type::const_iterator i = S.begin() ;
+                 i != S.end() ;
+                 ++i ) {
+                for( int j = 0 ; j < n ; j++ ) {
+                    raycast_collidable(
+                        rays[j], results[j], j, mode, *i, filter );
+                }
+            }
+            return;
+        }
+
+        for( int base = 0 ; base < n ; base += RAYCAST_PACKET_SIZE ) {
+            int m = std::min( n - base, RAYCAST_PACKET_SIZE );
+            raycast_visitor< Filter > v(
+                this, rays + base, results + base, base, m, mode, filter );
+            typename raycast_visitor< Filter >::state_type all = v.all();
+
+            aabbt_.traverse( v, all );
+            static_aabbt_.traverse( v, all );
+
+            traverse_query_islands( v, all );
+        }
+    }
+
+    // treeƂɖĂislandtreeɓĂȂ̂ŁA
+    // islandAABBōiĂ璆collidable𒲂ׂ
+    template < class Visitor >
+    void traverse_query_islands(
+        Visitor& v, typename Visitor::state_type s ) const
+    {
+        for( int k = 0 ; k < query_island_count_ ; k++ ) {
+            const island_type& island = islands_[k];
+            typename Visitor::state_type t;
+            if( !v.enter( island.bbmin, island.bbmax, s, t ) ) { continue; }
+
+            int end = query_island_begin_[k+1];
+            for( int i = query_island_begin_[k] ; i < end ; i++ ) {
+                collidable_type* c = query_island_units_[i];
+                typename Visitor::state_type u;
+                if( !v.enter( c->get_bbmin(), c->get_bbmax(), t, u ) ) {
+                    continue;
+                }
+                v.leaf( c, u );
+            }
+        }
+    }
+
+    void update_query_islands()
+    {
+        // islandfall_asleepŖɑ邩Awake_island
+        // query_tree_dirty_ɂȂ邩̂ǂ炩Ȃ̂ŁAΑ
+        int n = int( islands_.size() );
+        if( !query_tree_dirty_ && query_island_count_ == n ) { return; }
+
+        query_island_units_.clear();
+        query_island_begin_.resize( n + 1 );
+        for( int k = 0 ; k < n ; k++ ) {
+            query_island_begin_[k] = int( query_island_units_.size() );
+            const island_type& island = islands_[k];
+            for( typename bodies_type::const_iterator i =
+                     island.bodies.begin() ;
+                 i != island.bodies.end() ;
+                 ++i ) {
+                (*i)->list_collision_units( query_island_units_ );
+            }
+        }
+        query_island_begin_[n] = int( query_island_units_.size() );
+        query_island_count_ = n;
+    }
+
+    struct query_bb_getter {
+        void operator()(
+            collidable_type* c,
+            vector_type& bbmin,
+            vector_type& bbmax ) const
+        {
+            bbmin = c->get_bbmin();
+            bbmax = c->get_bbmax();
+        }
+    };
+
+    void refit_query_trees()
+    {
+        // broad phaseō蒼A
+        // (static tree)ωȂΓAABBɂȂ̂ŁA
+        // Փ˔̌ʂ͕ςȂ
+        if( query_tree_dirty_ ) { return; }
+        aabbt_.refit( query_bb_getter() );
+        static_aabbt_.refit( query_bb_getter() );
+    }
+
+    template < class Visitor >
+    void query_internal( Visitor& v )
+    {
+        if( query_tree_dirty_ ) {
+            // body̏o肪Ă܂treeĂȂ̂ő
+            // (̏ꍇ͊蓖ĂN肤)
+            collidables_type S;
+            list_all_collision_units( S );
+            for( typename collidables_type::const_iterator i = S.begin() ;
+                 i != S.end() ;
+                 ++i ) {
+                collidable_type* c = *i;
+                int t;
+                if( v.enter( c->get_bbmin(), c->get_bbmax(), 0, t ) ) {
+                    v.leaf( c, t );
+                }
+            }
+            return;
+        }
+
+        aabbt_.traverse( v, 0 );
+        static_aabbt_.traverse( v, 0 );
+        traverse_query_islands( v, 0 );
+    }
+
+    template < class Callback >
+    class aabb_query_visitor {
+    public:
+        typedef int state_type;
+
+        aabb_query_visitor( const vector_type& bbmin,
+                            const vector_type& bbmax,
+                            const Callback& c )
+            : bbmin_( bbmin ), bbmax_( bbmax ), c_( c ) {}
+
+        bool enter( const vector_type& bbmin, const vector_type& bbmax,
+                    state_type, state_type& ) const
+        {
+            return math< Traits >::test_aabb_aabb(
+                bbmin, bbmax, bbmin_, bbmax_ );
+        }
+        void leaf( collidable_type* c, state_type ) const { c_( c ); }
+
+    private:
+        vector_type         bbmin_;
+        vector_type         bbmax_;
+        const Callback&     c_;
+    };
+
+    template < class Callback >
+    class sphere_query_visitor {
+    public:
+        typedef int state_type;
+
+        sphere_query_visitor( const vector_type& center, real_type radius,
+                              const Callback& c )
+            : center_( center ), radius_( radius ), c_( c ) {}
+
+        bool enter( const vector_type& bbmin, const vector_type& bbmax,
+                    state_type, state_type& ) const
+        {
+            return math< Traits >::test_aabb_sphere(
+                bbmin, bbmax, center_, radius_ );
+        }
+        void leaf( collidable_type* c, state_type ) const { c_( c ); }
+
+    private:
+        vector_type         center_;
+        real_type           radius_;
+        const Callback&     c_;
+    };
+
+    template < class Callback >
+    class frustum_query_visitor {
+    public:
+        typedef int state_type;
+
+        frustum_query_visitor( const frustum_type& f, const Callback& c )
+            : c_( c )
+        {
+            // OɂĂtest_aabb_halfspace
+            // uꕔłɂvł
+            for( int i = 0 ; i < 6 ; i++ ) {
+                positions_[i] = f.positions[i];
+                outward_[i] = -f.normals[i];
+            }
+        }
+
+        bool enter( const vector_type& bbmin, const vector_type& bbmax,
+                    state_type, state_type& ) const
+        {
+            for( int i = 0 ; i < 6 ; i++ ) {
+                if( !math< Traits >::test_aabb_halfspace(
+                        bbmin, bbmax, positions_[i], outward_[i] ) ) {
+                    return false;
                 }
             }
+            return true;
         }
+        void leaf( collidable_type* c, state_type ) const { c_( c ); }
 
-        if( found ) {
-            if( distance ) { *distance = min_dist; }
-            return found->get_body();
+    private:
+        vector_type         positions_[6];
+        vector_type         outward_[6];
+        const Callback&     c_;
+    };
+
+    void list_all_collision_units( collidables_type& S )
+    {
+        for( typename bodies_type::const_iterator i = bodies_.begin() ;
+             i != bodies_.end() ;
+             ++i ) {
+            (*i)->list_collision_units( S );
+        }
+        for( typename islands_type::const_iterator i = islands_.begin() ;
+             i != islands_.end() ;
+             ++i ) {
+            for( typename bodies_type::const_iterator j =
+                     (*i).bodies.begin() ;
+                 j != (*i).bodies.end() ;
+                 ++j ) {
+                (*j)->list_collision_units( S );
+            }
         }
-        return NULL;
     }
 
 private:
@@ -440,6 +1335,7 @@ private:
 
     void begin_frame()
     {
+        page_provider_.get_arena().begin_frame();
         for( typename bodies_type::const_iterator i = bodies_.begin() ;
              i != bodies_.end() ;
              ++i ) {
@@ -474,7 +1370,34 @@ private:
              i != bodies_.end() ;
              ++i ) {
             body_type* p = (*i);
-            p->restore_shape( dt, idt, kmax );
+            p->restore_shape( dt, idt, kmax, 1 );
+        }
+    }
+                
+    void iterate_shape( real_type dt, real_type idt )
+    {
+        // 1ڂrestore_shapeōςł
+        shape_iteration_count_ = 1;
+        int kmax = shape_iterations_ - 1;
+        if( kmax == 0 ) { return; }
+
+        for( typename bodies_type::const_iterator i = bodies_.begin() ;
+             i != bodies_.end() ;
+             ++i ) {
+            body_type* p = (*i);
+            int k = 1;
+            for( ; k <= kmax ; k++ ) {
+                if( p->get_shape_residual() < shape_tolerance_ ) { break; }
+                p->match_shape();
+                p->restore_shape( dt, idt, kmax, 1 );
+            }
+            // ł؂ꍇ͎c̉񐔕܂Ƃ߂Ė߂A
+            // vrestore_factorɈv悤ɂ
+            // (ĉŖڕWʒu͂̂܂܎g)
+            if( k <= kmax ) {
+                p->restore_shape( dt, idt, kmax, kmax + 1 - k );
+            }
+            if( shape_iteration_count_ < k ) { shape_iteration_count_ = k; }
         }
     }
                 
@@ -491,8 +1414,12 @@ private:
     void clear_constraints()
     {
         constraints_.clear();
+        plane_constraints_.clear();
+        plane_points_.clear();
         contacts_.clear();
 		contact_pool_.clear();
+        contact_cache_.flip();
+        contact_cache_hit_count_ = 0;
     }
 
     void collect_constraints()
@@ -516,6 +1443,11 @@ private:
         
         void operator()( Collidable< PTraits >* y ) const
         {
+            // tB^ŒegneighborɂȂ
+            //   (narrow phasȇgʂɑ傫ȂȂ悤)
+            if( !x_->get_body()->test_collision_filter( y->get_body() ) ) {
+                return;
+            }
             w_->resolve_collision( x_, y );
         }
 
@@ -532,7 +1464,9 @@ private:
         pc.print( "broad0" );
         // ׂĂcollidablesrcW(S)ɓ
         // d͂ȂƉ
-        collidables_type S;
+        //   S, T, D͖t[g(蓖Ă邽)
+        collidables_type& S = broad_S_;
+        S.clear();
         for( typename bodies_type::const_iterator i = bodies_.begin() ;
              i != bodies_.end() ;
              ++i ) {
@@ -540,6 +1474,10 @@ private:
         }
         pc.print( "broad1" );
 
+        // planeƎ~܂Ăbodystatic treeɓ
+        //   (ωȂ΍蒼Ȃ)
+        update_static_tree( S );
+
         // Kł͈̂ʂɂ悭Ȃ
         std::random_shuffle( S.begin(), S.end() ); 
         pc.print( "broad2-0" );
@@ -559,6 +1497,7 @@ private:
         //// AABB version
 
         // AABB tree쐬  collision graph
+        //   aabbt_ɂstatic treeȊÔ̂
         aabbt_.clear();
         pc.print( "broad2-1" );
 
@@ -568,14 +1507,20 @@ private:
             collidable_type* b = *i;
             //assert(b);
             //printf("collidable: %p\n", b);
+            if( is_static_collidable( b ) ) { continue; }
             aabbt_.insert( b->get_bbmin(), b->get_bbmax(), b );
         }                        
         pc.print( "broad2-2" );
 
+        // raycastȂǂ̖₢킹͂treeg
+        update_query_islands();
+        query_tree_dirty_ = false;
+
         for( typename collidables_type::const_iterator i = S.begin() ;
              i != S.end() ;
              ++i ) {
             collidable_type* b = *i;
+            b->invalidate_face_normals();
             b->clear_neighbors();
             b->unmark();
         }                        
@@ -596,6 +1541,11 @@ private:
                     c->get_bbmax(),
                     broad_collision_collector< Traits >(
                         this, c ) );
+                static_aabbt_.detect(
+                    c->get_bbmin(),
+                    c->get_bbmax(),
+                    broad_collision_collector< Traits >(
+                        this, c ) );
             }
             // ̎_ b->collision_ ͗\܂
             // inactive vs inactive͂肦ȂA
@@ -610,6 +1560,7 @@ private:
              ++i ) {
             collidable_type* b = *i;
             broad_spatial_hash_.add_collidable( b );
+            b->invalidate_face_normals();
             b->clear_neighbors();
             b->unmark();
         }                        
@@ -645,8 +1596,10 @@ private:
         pc.print( "broad4" );
 
         // Otpartitioningnarrow collision phases
-        collidables_type T;
-        collidables_type D;
+        collidables_type& T = broad_T_;
+        collidables_type& D = broad_D_;
+        T.clear();
+        D.clear();
         for( typename collidables_type::const_iterator i = S.begin() ;
              i != S.end() ;
              ++i ) {
@@ -690,6 +1643,66 @@ private:
 
     }
 
+    static bool is_static_collidable( collidable_type* c )
+    {
+        body_type* b = c->get_body();
+        return is_static_body( b ) || is_calm_body( b );
+    }
+
+    static bool same_vector( const vector_type& a, const vector_type& b )
+    {
+        return a.x == b.x && a.y == b.y && a.z == b.z;
+    }
+
+    void update_static_tree( const collidables_type& S )
+    {
+        static_entries_type& E = static_entries_;
+
+        bool dirty = false;
+        size_t n = 0;
+        for( typename collidables_type::const_iterator i = S.begin() ;
+             i != S.end() ;
+             ++i ) {
+            collidable_type* c = *i;
+            if( !is_static_collidable( c ) ) { continue; }
+
+            vector_type bbmin = c->get_bbmin();
+            vector_type bbmax = c->get_bbmax();
+            if( n < E.size() ) {
+                static_entry_type& e = E[n];
+                if( e.collidable != c ||
+                    !same_vector( e.bbmin, bbmin ) ||
+                    !same_vector( e.bbmax, bbmax ) ) {
+                    dirty = true;
+                }
+            } else {
+                dirty = true;
+            }
+            if( dirty ) {
+                if( n < E.size() ) { E.resize( n ); }
+                static_entry_type e;
+                e.collidable = c;
+                e.bbmin = bbmin;
+                e.bbmax = bbmax;
+                E.push_back( e );
+            }
+            n++;
+        }
+        if( n != E.size() ) {
+            E.resize( n );
+            dirty = true;
+        }
+        if( !dirty ) { return; }
+
+        static_aabbt_.clear();
+        for( typename static_entries_type::const_iterator i = E.begin() ;
+             i != E.end() ;
+             ++i ) {
+            static_aabbt_.insert(
+                (*i).bbmin, (*i).bbmax, (*i).collidable );
+        }
+    }
+
     void narrow_collision_phase( const collidables_type& D )
     {
         PerformanceCounter pc( false );
@@ -743,12 +1756,8 @@ private:
             const face_type& f = fp->get_faces()[fi];
 
             const vector_type& v0 = fpoints[f.i0].new_position;
-            const vector_type& v1 = fpoints[f.i1].new_position;
-            const vector_type& v2 = fpoints[f.i2].new_position;
-                        
-            vector_type plane_normal;
-            plane_normal = math< InnerTraits >::cross( v1 - v0, v2 - v0 );
-            math< InnerTraits >::normalize_f( plane_normal );
+            const vector_type& plane_normal =
+                fp->get_volume()->get_face_normals()[fi];
 
             world_->add_constraint(
                 ep,
@@ -783,12 +1792,8 @@ private:
             const face_type& f = fp->get_faces()[fi];
 
             const vector_type& v0 = fpoints[f.i0].new_position;
-            const vector_type& v1 = fpoints[f.i1].new_position;
-            const vector_type& v2 = fpoints[f.i2].new_position;
-                        
-            vector_type plane_normal;
-            plane_normal = math< InnerTraits >::cross( v1 - v0, v2 - v0 );
-            math< InnerTraits >::normalize_f( plane_normal );
+            const vector_type& plane_normal =
+                fp->get_volume()->get_face_normals()[fi];
 
             world_->add_constraint(
                 sp,
@@ -807,8 +1812,8 @@ private:
         real_type edge_ave = 0;
 
         // 0th stage: volumecloth𕪗
-        std::vector< softvolume_type* > volumes;
-        std::vector< cloth_type* >      clothes;
+        scratch_softvolumes_type volumes( scratch_ );
+        scratch_clothes_type     clothes( scratch_ );
 
         bool have_attacker = false;
 
@@ -963,6 +1968,11 @@ private:
         void operator()( mesh_type* vp, index_type vi,
                          mesh_type* tp, index_type ti ) const
         {
+            // neighborłȂĂnarrow phasȇgɂΗ̂
+            if( !vp->get_volume()->test_collision_filter(
+                    tp->get_volume() ) ) {
+                return;
+            }
             vp->get_points()[vi].collided = true;
         }
 
@@ -987,6 +1997,10 @@ private:
 
             real_type t = real_type( 1.0 ) - uvt.z;
             if( e.t < t ) { return; }
+            if( !ep->get_volume()->test_collision_filter(
+                    fp->get_volume() ) ) {
+                return;
+            }
 
             e.u = uvt.x;
             e.v = uvt.y;
@@ -1044,7 +2058,8 @@ private:
                 uvt.x,
                 uvt.y,
 				real_type( 1.0 ) - uvt.x - uvt.y,
-				uvt.z );
+				uvt.z,
+                &fp->get_volume()->get_face_normals()[fi] );
         }
 
     private:
@@ -1062,7 +2077,7 @@ private:
         //            łɃGbW̒̕ς
         bool have_attacker = false;
 
-        std::vector< softvolume_type* > D;
+        scratch_softvolumes_type D( scratch_ );
         int n = int( D2.size() ); 
         real_type edge_ave = 0;
         for( int i = 0 ; i < n ; i++ ) {
@@ -1100,8 +2115,7 @@ private:
         if( n < 2 ) { return; }
 
         point_tetrahedron_spatial_hash_.clear( edge_ave );
-        edge_face_spatial_hash_.clear( edge_ave );
-        penetration_face_spatial_hash_.clear( edge_ave );
+        volume_face_spatial_hash_.clear( edge_ave );
         pc.print( "narrow2" );
 
         // 1st stage: point - tetrahedron intersection
@@ -1131,11 +2145,13 @@ private:
         // ..activȇ}
         for( int i = 0 ; i < n ; i++ ) {
             softvolume_type* volume = D[i];
-            volume->mark_border_edges( edge_face_spatial_hash_ );
+            volume->mark_border_edges( volume_face_spatial_hash_ );
         } 
         pc.print( "narrow6" );
 
         // ..passivȇ}
+        //   faceadditional stageł̂܂܎g
+        //   (3rd, 4th stagełpoint͓Ȃ)
         for( int i = 0 ; i < n ; i++ ) {
             softvolume_type* volume = D[i];
 
@@ -1144,14 +2160,14 @@ private:
 
             int m = int( faces.size() );
             for( int j = 0 ; j < m ; j++ ) {
-                edge_face_spatial_hash_.add_face(
+                volume_face_spatial_hash_.add_face(
                     volume->get_mesh(), j );
             }
         } 
         pc.print( "narrow7" );
 
         // ..matchs
-        edge_face_spatial_hash_.apply(
+        volume_face_spatial_hash_.apply_edges(
             edge_face_spatial_hash_replier< Traits >( this ) );
         pc.print( "narrow8" );
 
@@ -1186,7 +2202,11 @@ private:
                 if( !p.collided ) { continue; }
                 if( p.penetration_denominator < epsilon() ) { continue; }
 
-                penetration_face_spatial_hash_.add_penetration(
+                // Ot[Ɠʂɂ܂hĂ΂l
+                //   (߂ʂ͉̌Œu)
+                seed_cached_penetration( volume, p );
+
+                volume_face_spatial_hash_.add_penetration(
                     volume->get_mesh(), j );
             }
 
@@ -1194,23 +2214,8 @@ private:
         }
         pc.print( "narrow11" );
 
-        // ...passive}
-        for( int i = 0 ; i < n ; i++ ) {
-            softvolume_type* volume = D[i];
-
-            // face̓o^
-            typename softvolume_type::mesh_type::faces_type& faces
-                = volume->get_mesh()->get_faces();
-            int m = int( faces.size() );
-            for( int j = 0 ; j < m ; j++ ) {
-                penetration_face_spatial_hash_.add_face(
-                    volume->get_mesh(), j );
-            }
-        }
-        pc.print( "narrow12" );
-
-        // ..spatial hash Kp
-        penetration_face_spatial_hash_.apply(
+        // ..spatial hash Kp(passive2nd stageœo^ς)
+        volume_face_spatial_hash_.apply_penetrations(
             penetration_face_spatial_hash_replier< Traits >(
                 this ) );
         pc.print( "narrow13" );
@@ -1222,76 +2227,382 @@ private:
                      constraints_.size() );
             OutputDebugStringA( buffer );
         }
-#endif
+#endif
+    }
+
+    void apply_constraints()
+    {
+		// 
+        for( typename constraints_type::iterator i =
+                 constraints_.begin() ;
+             i != constraints_.end() ;
+             ++i ) {
+            begin_constraint( (*i).point );
+		}
+        for( typename plane_points_type::iterator i = plane_points_.begin() ;
+             i != plane_points_.end() ;
+             ++i ) {
+            begin_constraint( *i );
+        }
+
+		// C͂̌vZ
+        for( typename constraints_type::iterator i =
+                 constraints_.begin() ;
+             i != constraints_.end() ;
+             ++i ) {
+            constraint_type& c = *i;
+            compute_constraint_friction(
+                c.point, c.plane_normal, c.plane_position );
+		}		
+        for( typename plane_constraints_type::iterator i =
+                 plane_constraints_.begin() ;
+             i != plane_constraints_.end() ;
+             ++i ) {
+            plane_constraint_type& c = *i;
+            const vector_type& n = c.plane->get_normal();
+            const vector_type& q = c.plane->get_position();
+            for( int j = c.begin ; j < c.end ; j++ ) {
+                compute_constraint_friction( plane_points_[j], n, q );
+            }
+        }
+
+        // 
+        for( typename constraints_type::iterator i =
+                 constraints_.begin() ;
+             i != constraints_.end() ;
+             ++i ) {
+            constraint_type& c = *i;
+            apply_constraint( c.point, c.plane_normal, c.plane_position );
+        }
+        for( typename plane_constraints_type::iterator i =
+                 plane_constraints_.begin() ;
+             i != plane_constraints_.end() ;
+             ++i ) {
+            plane_constraint_type& c = *i;
+            const vector_type& n = c.plane->get_normal();
+            const vector_type& q = c.plane->get_position();
+            for( int j = c.begin ; j < c.end ; j++ ) {
+                apply_constraint( plane_points_[j], n, q );
+            }
+        }
+    }
+
+    void begin_constraint( point_type* p )
+    {
+        p->tmp_velocity = p->new_position - p->old_position;
+        p->friction_vector = math< Traits >::vector_zero();
+    }
+
+    void compute_constraint_friction(
+        point_type*         p,
+        const vector_type&  n, // normalized
+        const vector_type&  plane_position )
+    {
+        real_type npdotn = dot( p->new_position - plane_position, n );
+        if( 0 <= npdotn ) { return; }
+        vector_type u = -p->tmp_velocity;
+        real_type udotn = dot( u, n );
+        vector_type un = n * udotn;	// normal velocity
+        vector_type ut = u - un;	// tangencial velocity
+        real_type utlen = length( ut );
+        if( utlen < epsilon() ) { return; }
+        real_type unlen = std::abs( udotn );
+
+        real_type mu = p->friction;
+        real_type friction = unlen * mu;
+        if( utlen < friction ) {
+            friction = utlen;
+        }
+
+        p->friction_vector += ut * ( friction / utlen );
+    }
+
+    void apply_constraint(
+        point_type*         p,
+        const vector_type&  n,
+        const vector_type&  plane_position )
+    {
+        p->new_position += p->friction_vector;
+
+        // ylg[V
+        real_type npdotn = dot( p->new_position - plane_position, n );
+        if( 0 <= npdotn ) {
+            if( swept_collision_ ) { limit_approach( p, n, npdotn ); }
+            return;
+        }
+
+        real_type nlen = -npdotn;
+        vector_type penetration = n * nlen;
+
+        p->new_position += penetration;
+        p->constraint_pushout += penetration;
+
+        p->check();
+    }
+
+    void limit_approach(
+        point_type*         p,
+        const vector_type&  n,
+        real_type           distance )
+    {
+        // ̃Xebvł傤ǖʂɓ͂܂ŋ߂Âx𗎂Ƃ
+        real_type vn = dot( p->new_position - p->old_position, n );
+        if( -distance <= vn ) { return; }
+        p->old_position += n * ( vn + distance );
+    }
+
+    void seed_cached_penetration( softvolume_type* volume, point_type& p )
+    {
+        if( !contact_cache_enabled_ ) { return; }
+
+        const contact_cache_entry_type* e = contact_cache_.find( &p );
+        if( !e ) { return; }
+
+        body_type* B_body = e->B_body;
+        if( B_body->classid() != BODY_ID_SOFTVOLUME ) { return; }
+        if( 0 <= B_body->get_island() ) { return; }
+
+        // penetration_face_spatial_hash_replierƓ
+        const vector_type& r0 = p.new_position;
+        vector_type r1 = r0 + p.penetration_vector;
+        vector_type uvt;
+        if( !math< Traits >::test_ray_triangle(
+                r0, r1,
+                e->B_point0->new_position,
+                e->B_point2->new_position, // \]
+                e->B_point1->new_position, // \]
+                uvt ) ) {
+            return;
+        }
+        std::swap( uvt.x, uvt.y );
+
+        add_contact(
+            volume,
+            B_body,
+            &p,
+            e->B_point0,
+            e->B_point1,
+            e->B_point2,
+            uvt.x,
+            uvt.y,
+            real_type( 1.0 ) - uvt.x - uvt.y,
+            uvt.z );
+        contact_cache_hit_count_++;
+    }
+
+    struct reduced_member_type {
+        point_type*     point;
+        contact_type*   representative;
+    };
+    typedef std::vector< reduced_member_type >      reduced_members_type;
+
+    struct contact_pair_less {
+        bool operator()( const contact_type* x, const contact_type* y ) const
+        {
+            // AhXł͂ȂidŕׂĎsƂɓʂɂ
+            int xa = x->A_body->get_id();
+            int ya = y->A_body->get_id();
+            if( xa != ya ) { return xa < ya; }
+            return x->B_body->get_id() < y->B_body->get_id();
+        }
+    };
+
+    // (A_body, B_body)Ƃcontactcontact_reduction_cap_܂łɌ炷
+    //   A_poinẗʒuő\I(ł[ + farthest point)A
+    //   c͍Ŋ̑\ɂ܂Ƃ߂B\͎ʂpenetration vector
+    //   ʏdݕtςp̂ŁABւ̉ỏ^ʂ͕ςȂB
+    //   ςContact::penetration_vectorɎAA_point͕̂̂ςȂ
+    void reduce_contacts()
+    {
+        reduction_sorted_.assign( contacts_.begin(), contacts_.end() );
+        std::stable_sort(
+            reduction_sorted_.begin(), reduction_sorted_.end(),
+            contact_pair_less() );
+
+        int n = int( reduction_sorted_.size() );
+        int cap = contact_reduction_cap_;
+        bool reduced = false;
+        for( int begin = 0 ; begin < n ; ) {
+            int end = begin + 1;
+            while( end < n &&
+                   !contact_pair_less()(
+                       reduction_sorted_[begin], reduction_sorted_[end] ) ) {
+                end++;
+            }
+            if( cap < end - begin ) {
+                reduce_contact_pair( begin, end, cap );
+                reduced = true;
+            }
+            begin = end;
+        }
+        if( !reduced ) { return; }
+
+        // \̏Ŏc(mass0̂̂͊Ԉꂽ)
+        typename contacts_type::iterator j = contacts_.begin();
+        for( typename contacts_type::iterator i = contacts_.begin() ;
+             i != contacts_.end() ;
+             ++i ) {
+            if( (*i)->mass == 0 ) { continue; }
+            *j++ = *i;
+        }
+        contacts_.erase( j, contacts_.end() );
+
+        // tcontact(ӂɎhƂȂ)A_pointL̂ŁA
+        // ccontactA_point⓯pointdēȂ悤ɂ
+        for( typename reduced_members_type::iterator i =
+                 reduced_members_.begin() ;
+             i != reduced_members_.end() ;
+             ++i ) {
+            (*i).point->process_flag = false;
+        }
+        for( typename contacts_type::iterator i = contacts_.begin() ;
+             i != contacts_.end() ;
+             ++i ) {
+            (*i)->A_point->process_flag = true;
+        }
+        typename reduced_members_type::iterator k = reduced_members_.begin();
+        for( typename reduced_members_type::iterator i =
+                 reduced_members_.begin() ;
+             i != reduced_members_.end() ;
+             ++i ) {
+            if( (*i).point->process_flag ) { continue; }
+            (*i).point->process_flag = true;
+            *k++ = *i;
+        }
+        reduced_members_.erase( k, reduced_members_.end() );
     }
 
-    void apply_constraints()
+    void reduce_contact_pair( int begin, int end, int cap )
     {
-        const vector_type& v0 = math< Traits >::vector_zero();
-
-		// 
-        for( typename constraints_type::iterator i =
-                 constraints_.begin() ;
-             i != constraints_.end() ;
-             ++i ) {
-            constraint_type& c = *i;
-			c.point->tmp_velocity =
-				c.point->new_position -
-				c.point->old_position;
-			c.point->friction_vector = v0;
-		}
+        int n = end - begin;
+        contact_type** g = &reduction_sorted_[begin];
 
-		// C͂̌vZ
-        for( typename constraints_type::iterator i =
-                 constraints_.begin() ;
-             i != constraints_.end() ;
-             ++i ) {
-            constraint_type& c = *i;
+        reduction_distance_.resize( n );
+        reduction_nearest_.resize( n );
 
-			// C
-			const vector_type& n = c.plane_normal; // normalized
-            real_type npdotn = dot(
-				c.point->new_position - c.plane_position, n );
-            if( 0 <= npdotn ) { continue; }
-            vector_type u = -c.point->tmp_velocity;
-			real_type udotn = dot( u, n );
-			vector_type un = n * udotn;	// normal velocity
-			vector_type ut = u - un;	// tangencial velocity
-			real_type utlen = length( ut );
-			if( utlen < epsilon() ) { continue; }
-			real_type unlen = std::abs( udotn );
-
-			real_type mu = c.point->friction;
-			real_type friction = unlen * mu;
-			if( utlen < friction ) {
-				friction = utlen;
-			}
+        // ł[̂n߂
+        int first = 0;
+        real_type deepest = -1;
+        for( int i = 0 ; i < n ; i++ ) {
+            real_type l = length_sq( g[i]->penetration_vector );
+            if( deepest < l ) { deepest = l; first = i; }
+        }
 
-			c.point->friction_vector += ut * ( friction / utlen );
-		}		
+        for( int i = 0 ; i < n ; i++ ) {
+            reduction_distance_[i] = math< Traits >::real_max();
+            reduction_nearest_[i] = -1;
+        }
+
+        int chosen = first;
+        for( int k = 0 ; k < cap ; k++ ) {
+            reduction_nearest_[chosen] = chosen;
+            reduction_distance_[chosen] = 0;
+
+            const vector_type& q = g[chosen]->A_point->new_position;
+            int farthest = -1;
+            real_type farthest_distance = 0;
+            for( int i = 0 ; i < n ; i++ ) {
+                real_type d = length_sq( g[i]->A_point->new_position - q );
+                if( d < reduction_distance_[i] ) {
+                    reduction_distance_[i] = d;
+                    reduction_nearest_[i] = chosen;
+                }
+                if( farthest_distance < reduction_distance_[i] ) {
+                    farthest_distance = reduction_distance_[i];
+                    farthest = i;
+                }
+            }
+            if( farthest < 0 ) { break; }
+            chosen = farthest;
+        }
 
-        // 
-        for( typename constraints_type::iterator i =
-                 constraints_.begin() ;
-             i != constraints_.end() ;
-             ++i ) {
-            constraint_type& c = *i;
+        // \Ɏʂpenetration vectorW߂
+        for( int i = 0 ; i < n ; i++ ) {
+            if( reduction_nearest_[i] != i ) { continue; }
+            contact_type* c = g[i];
+            c->penetration_vector *= c->mass;
+        }
+        for( int i = 0 ; i < n ; i++ ) {
+            int r = reduction_nearest_[i];
+            if( r == i ) { continue; }
+            contact_type* c = g[i];
+            contact_type* rc = g[r];
+            rc->penetration_vector += c->penetration_vector * c->mass;
+            rc->mass += c->mass;
+            c->mass = 0;
+
+            reduced_member_type e;
+            e.point = c->A_point;
+            e.representative = rc;
+            reduced_members_.push_back( e );
+        }
+        for( int i = 0 ; i < n ; i++ ) {
+            if( reduction_nearest_[i] != i ) { continue; }
+            contact_type* c = g[i];
+            c->penetration_vector *= real_type( 1 ) / c->mass;
+        }
+    }
 
-			c.point->new_position += c.point->friction_vector;
+    struct contact_incidence_type {
+        point_type*     point;
+        int             contact;
+        int             vertex; // 0: B_point0(w), 1: B_point1(u), 2: B_point2(v),
+                                // 3: A_point
 
-			// ylg[V
-			const vector_type& n = c.plane_normal;
-            real_type npdotn = dot(
-				c.point->new_position - c.plane_position, n );
-            if( 0 <= npdotn ) { continue; }
+        bool operator<( const contact_incidence_type& x ) const
+        {
+            if( point != x.point ) {
+                return std::less< point_type* >()( point, x.point );
+            }
+            if( contact != x.contact ) { return contact < x.contact; }
+            return vertex < x.vertex;
+        }
+    };
+    typedef std::vector< contact_incidence_type >   contact_incidences_type;
 
-            real_type nlen = -npdotn;
-            vector_type penetration = n * nlen;
+    void make_contact_incidences()
+    {
+        contact_incidences_.clear();
+        active_incidences_.clear();
+
+        int n = int( contacts_.size() );
+        for( int k = 0 ; k < n ; k++ ) {
+            contact_type& c = *contacts_[k];
+            contact_incidence_type e0 = { c.B_point0, k, 0 };
+            contact_incidence_type e1 = { c.B_point1, k, 1 };
+            contact_incidence_type e2 = { c.B_point2, k, 2 };
+            contact_incidence_type ea = { c.A_point, k, 3 };
+            contact_incidences_.push_back( e0 );
+            contact_incidences_.push_back( e1 );
+            contact_incidences_.push_back( e2 );
+            active_incidences_.push_back( ea );
+        }
+        group_incidences( contact_incidences_, passive_points_ );
+        group_incidences( active_incidences_, active_points_ );
+    }
 
-			c.point->new_position += penetration;
-			c.point->constraint_pushout += penetration;
+    static void group_incidences(
+        contact_incidences_type& incidences, std::vector< int >& heads )
+    {
+        std::sort( incidences.begin(), incidences.end() );
+
+        // point̕т̐擪
+        heads.clear();
+        int m = int( incidences.size() );
+        for( int j = 0 ; j < m ; j++ ) {
+            if( j == 0 || incidences[j].point != incidences[j-1].point ) {
+                heads.push_back( j );
+            }
+        }
+        heads.push_back( m );
+    }
 
-            c.point->check();
+    static real_type incidence_weight( const contact_type& c, int vertex )
+    {
+        switch( vertex ) {
+            case 0: return c.w;
+            case 1: return c.u;
+            default: return c.v;
         }
     }
 
@@ -1316,146 +2627,166 @@ private:
 				contact_remover() ),
 			contacts_.end() );
 
-        // ڐG
-        // ..
-        for( typename contacts_type::iterator i = contacts_.begin() ;
+        for( typename contacts_type::const_iterator i = contacts_.begin() ;
              i != contacts_.end() ;
              ++i ) {
-            contact_type& c = **i;
-            c.check();
-
-            // active point
-            c.A_point->contact = c1;
-            c.A_point->process_flag = false;
-			c.A_point->friction_vector = zero;
-			c.A_point->view_vector1 = c.A_point->new_position;
+            (*i)->penetration_vector = (*i)->A_point->penetration_vector;
+        }
 
-            // passive points
-            c.B_point0->contact = c1;
-            c.B_point0->process_flag = false;
-			c.B_point0->friction_vector = zero;
+        // body̑gƂcontactԈ
+        contact_count_before_reduction_ = int( contacts_.size() );
+        reduced_members_.clear();
+        if( 0 < contact_reduction_cap_ ) {
+            reduce_contacts();
+        }
 
-            c.B_point1->contact = c1;
-            c.B_point1->process_flag = false;
-			c.B_point1->friction_vector = zero;
+        // active point, passive pointւ̊^̈ꗗ
+        //   (point, contact)ɕׂĂApointƂcontactŏB
+        //   tcontact(ӂɎhƂȂ)A_pointL邪A
+        //   ň̂ŎU΂݂ȂȂA
+        //   ȉ̊epXpointƂɓƗ(PARTIX_PARALLEL_FORŕ񉻂ł)ŁA
+        //   ʂcontactɒꍇƃrbgPʂňv
+        make_contact_incidences();
 
-            c.B_point2->contact = c1;
-            c.B_point2->process_flag = false;
-			c.B_point2->friction_vector = zero;
+        const int contact_count = int( contacts_.size() );
+        const int active_count = int( active_points_.size() ) - 1;
+        const int passive_count = int( passive_points_.size() ) - 1;
 
-#if 0
-			c.A_point->tmp_velocity =
-				c.A_point->new_position -
-				c.A_point->old_position;
-			c.B_point0->tmp_velocity =
-				c.B_point0->new_position -
-				c.B_point0->old_position;
-			c.B_point1->tmp_velocity =
-				c.B_point1->new_position -
-				c.B_point1->old_position;
-			c.B_point2->tmp_velocity =
-				c.B_point2->new_position -
-				c.B_point2->old_position;
-#endif
+        // ڐG
+        // ..
+        PARTIX_PARALLEL_FOR
+        for( int k = 0 ; k < contact_count ; k++ ) {
+            contacts_[k]->check();
+        }
+        PARTIX_PARALLEL_FOR
+        for( int g = 0 ; g < active_count ; g++ ) {
+            // active point
+            point_type* p = active_incidences_[active_points_[g]].point;
+            p->contact = c1;
+            p->process_flag = false;
+			p->friction_vector = zero;
+			p->view_vector1 = p->new_position;
+        }
+        PARTIX_PARALLEL_FOR
+        for( int g = 0 ; g < passive_count ; g++ ) {
+            // passive points
+            point_type* p = contact_incidences_[passive_points_[g]].point;
+            p->contact = c1;
+            p->process_flag = false;
+			p->friction_vector = zero;
         }
 
         // ..c萔(̕)̎W
-        for( typename contacts_type::iterator i = contacts_.begin() ;
-             i != contacts_.end() ;
-             ++i ) {
-            contact_type& c = **i;
-
-            c.B_point0->contact += c.w;
-            c.B_point1->contact += c.u;
-            c.B_point2->contact += c.v;
+        PARTIX_PARALLEL_FOR
+        for( int g = 0 ; g < passive_count ; g++ ) {
+            int begin = passive_points_[g];
+            int end = passive_points_[g+1];
+            point_type* p = contact_incidences_[begin].point;
+
+            real_type contact = p->contact;
+            for( int j = begin ; j < end ; j++ ) {
+                const contact_incidence_type& e = contact_incidences_[j];
+                contact += incidence_weight( *contacts_[e.contact], e.vertex );
+            }
+            p->contact = contact;
         }
 
         // ..active apply
-        for( typename contacts_type::iterator i = contacts_.begin() ;
-             i != contacts_.end() ;
-             ++i ) {
-            contact_type& c = **i;
+        //   A_pointLcontact͌̂̂c
+        PARTIX_PARALLEL_FOR
+        for( int g = 0 ; g < active_count ; g++ ) {
+            int begin = active_points_[g];
+            int end = active_points_[g+1];
+            point_type* p = active_incidences_[begin].point;
+
+            for( int j = begin ; j < end ; j++ ) {
+                contact_type& c = *contacts_[active_incidences_[j].contact];
 			
-            // o
-            // _i
-            c.alpha =
-                c.w * c.B_point0->mass / c.B_point0->contact +
-                c.u * c.B_point1->mass / c.B_point1->contact +
-                c.v * c.B_point2->mass / c.B_point2->contact;
-            c.alpha /= ( c.A_point->mass / c.A_point->contact + c.alpha );
-            c.check();
+                // o
+                // _i(͍̐ڐGŌ܂̂ŖvZ)
+                c.alpha =
+                    c.w * c.B_point0->mass / c.B_point0->contact +
+                    c.u * c.B_point1->mass / c.B_point1->contact +
+                    c.v * c.B_point2->mass / c.B_point2->contact;
+                c.alpha /= ( c.mass / p->contact + c.alpha );
+                c.check();
                         
-			// t^2/miFi = t^2/mi * mi/t^2 * pv * Ȃ̂
-			// pv * 
-            vector_type pushout =
-				( c.A_point->penetration_vector ) *
-				c.alpha;
+                // t^2/miFi = t^2/mi * mi/t^2 * pv * Ȃ̂
+                // pv * 
+                vector_type pushout =
+                    ( c.penetration_vector ) *
+                    c.alpha;
 
-			c.A_point->active_contact_pushout = pushout;
-			c.A_point->check();
+                p->active_contact_pushout = pushout;
+            }
+			p->check();
         }
 
 #if 1
         // ..passive apply
-        for( typename contacts_type::iterator i = contacts_.begin() ;
-             i != contacts_.end() ;
-             ++i ) {
-            contact_type& c = **i;
-
-            vector_type fi_dt =
-				c.A_point->active_contact_pushout *
-				c.A_point->mass;
-
-			vector_type pushout0 = fi_dt * ( -c.B_point0->invmass * c.w );
-			vector_type pushout1 = fi_dt * ( -c.B_point1->invmass * c.u );
-			vector_type pushout2 = fi_dt * ( -c.B_point2->invmass * c.v );
-			c.B_point0->passive_contact_pushout += pushout0;
-			c.B_point1->passive_contact_pushout += pushout1;
-			c.B_point2->passive_contact_pushout += pushout2;
+        PARTIX_PARALLEL_FOR
+        for( int g = 0 ; g < passive_count ; g++ ) {
+            int begin = passive_points_[g];
+            int end = passive_points_[g+1];
+            point_type* p = contact_incidences_[begin].point;
+
+            vector_type pushout = p->passive_contact_pushout;
+            for( int j = begin ; j < end ; j++ ) {
+                const contact_incidence_type& e = contact_incidences_[j];
+                const contact_type& c = *contacts_[e.contact];
+
+                vector_type fi_dt =
+                    c.A_point->active_contact_pushout *
+                    c.mass;
+
+                pushout += fi_dt * (
+                    -p->invmass * incidence_weight( c, e.vertex ) );
+            }
+            p->passive_contact_pushout = pushout;
         }
 #endif
 
 		// pushoutKp
-        for( typename contacts_type::iterator i = contacts_.begin() ;
-             i != contacts_.end() ;
-             ++i ) {
-            contact_type& c = **i;
-
-			vector_type v = c.A_point->active_contact_pushout;
-			if( length_sq( c.A_point->active_contact_pushout ) <
-				length_sq( c.A_point->passive_contact_pushout ) ) {
-				v = c.A_point->passive_contact_pushout;
-				c.A_point->active_contact_pushout = zero;
-			} else {
-				c.A_point->passive_contact_pushout = zero;
-			}
+        //   A_pointLcontactcontactƂɓKp
+        //   (displacement͂pointv)
+        PARTIX_PARALLEL_FOR
+        for( int g = 0 ; g < active_count ; g++ ) {
+            int begin = active_points_[g];
+            int end = active_points_[g+1];
+            point_type* p = active_incidences_[begin].point;
+
+            vector_type displacement = zero;
+            for( int j = begin ; j < end ; j++ ) {
+                vector_type v = p->active_contact_pushout;
+                if( length_sq( p->active_contact_pushout ) <
+                    length_sq( p->passive_contact_pushout ) ) {
+                    v = p->passive_contact_pushout;
+                    p->active_contact_pushout = zero;
+                } else {
+                    p->passive_contact_pushout = zero;
+                }
 
-			c.A_point->new_position += v;
-			c.A_point->tmp_velocity =
-				c.A_point->new_position -
-				c.A_point->old_position;
-			c.A_point->process_flag = true;
+                p->new_position += v;
+                displacement += v;
+            }
+            for( int j = begin ; j < end ; j++ ) {
+                contacts_[active_incidences_[j].contact]->displacement =
+                    displacement;
+            }
+			p->tmp_velocity =
+				p->new_position -
+				p->old_position;
+			p->process_flag = true;
 		}
 
 #if 1
-        for( typename contacts_type::iterator i = contacts_.begin() ;
-             i != contacts_.end() ;
-             ++i ) {
-            contact_type& c = **i;
-			if( !c.B_point0->process_flag ) {
-				c.B_point0->new_position +=
-					c.B_point0->passive_contact_pushout;
-				c.B_point0->process_flag = true;
-			}
-			if( !c.B_point1->process_flag ) {
-				c.B_point1->new_position +=
-					c.B_point1->passive_contact_pushout;
-				c.B_point1->process_flag = true;
-			}
-			if( !c.B_point2->process_flag ) {
-				c.B_point2->new_position +=
-					c.B_point2->passive_contact_pushout;
-				c.B_point2->process_flag = true;
+        // active point˂passive point͏ŏς
+        PARTIX_PARALLEL_FOR
+        for( int g = 0 ; g < passive_count ; g++ ) {
+            point_type* p = contact_incidences_[passive_points_[g]].point;
+			if( !p->process_flag ) {
+				p->new_position += p->passive_contact_pushout;
+				p->process_flag = true;
 			}
 		}
 #endif
@@ -1491,65 +2822,87 @@ private:
 		
 #if 1
         // CvZ
-        for( typename contacts_type::iterator i = contacts_.begin() ;
-             i != contacts_.end() ;
-             ++i ) {
-            contact_type& c = **i;
-			c.A_point->process_flag = false;
+        PARTIX_PARALLEL_FOR
+        for( int g = 0 ; g < active_count ; g++ ) {
+            int begin = active_points_[g];
+            int end = active_points_[g+1];
+            point_type* p = active_incidences_[begin].point;
+			p->process_flag = false;
 
 #if 0
-			if( length( c.A_point->active_contact_pushout ) <
-				length( c.A_point->passive_contact_pushout ) ) {
+			if( length( p->active_contact_pushout ) <
+				length( p->passive_contact_pushout ) ) {
 				dprintf_real( "p" );
 			} else {
 				dprintf_real( "a" );
 			}
 #endif
 
-			vector_type nsrc = c.A_point->active_contact_pushout;
+			vector_type nsrc = p->active_contact_pushout;
 			// passive_contact_pushout͖Ă悢
 			real_type nlen = length( nsrc );
 			if( nlen < epsilon() ) { continue; }
 
 			vector_type n = nsrc * ( real_type(1) / nlen );
 			
-			vector_type va = c.A_point->tmp_velocity;
+			vector_type va = p->tmp_velocity;
+			real_type mu = p->friction;
 
-            vector_type vb =
-				c.B_point0->tmp_velocity * c.w +
-				c.B_point1->tmp_velocity * c.u +
-				c.B_point2->tmp_velocity * c.v;
+            // A_pointLcontact͌̂̂c
+            for( int j = begin ; j < end ; j++ ) {
+                const contact_type& c =
+                    *contacts_[active_incidences_[j].contact];
 
-			real_type mu = c.A_point->friction;
+                vector_type vb =
+                    c.B_point0->tmp_velocity * c.w +
+                    c.B_point1->tmp_velocity * c.u +
+                    c.B_point2->tmp_velocity * c.v;
 
-			vector_type u = ( vb - va ) * c.alpha;
-			vector_type un = n * dot( n, u );
-			vector_type ut = u - un; // tangential velocity
+                vector_type u = ( vb - va ) * c.alpha;
+                vector_type un = n * dot( n, u );
+                vector_type ut = u - un; // tangential velocity
 
-			real_type friction = nlen * mu;
-			real_type max_friction = length( ut );
-			if( max_friction < friction ) { friction = max_friction; }
+                real_type friction = nlen * mu;
+                real_type max_friction = length( ut );
+                if( max_friction < friction ) { friction = max_friction; }
 
-			c.A_point->friction_vector =
-				ut * friction * ( real_type(1) / max_friction );
-            c.A_point->check();
+                p->friction_vector =
+                    ut * friction * ( real_type(1) / max_friction );
+            }
+            p->check();
         }
 #endif
 		//dprintf_real( "\n" );
 
 		// CKp
-		vector_type total_friction = zero;
-        for( typename contacts_type::iterator i = contacts_.begin() ;
-             i != contacts_.end() ;
-             ++i ) {
-            contact_type& c = **i;
-			if( c.A_point->process_flag ) { continue; }
-			c.A_point->process_flag = true;
-
-			c.A_point->new_position += c.A_point->friction_vector;
-			total_friction += c.A_point->friction_vector;
+        PARTIX_PARALLEL_FOR
+        for( int g = 0 ; g < active_count ; g++ ) {
+            int begin = active_points_[g];
+            int end = active_points_[g+1];
+            point_type* p = active_incidences_[begin].point;
+			if( p->process_flag ) { continue; }
+			p->process_flag = true;
+
+			p->new_position += p->friction_vector;
+            for( int j = begin ; j < end ; j++ ) {
+                contacts_[active_incidences_[j].contact]->displacement +=
+                    p->friction_vector;
+            }
 		}
 
+        // ԈꂽcontactA_point͑\Ɠ
+        //   (\passivẻoI񂾏ꍇɍ킹)
+        const int member_count = int( reduced_members_.size() );
+        PARTIX_PARALLEL_FOR
+        for( int k = 0 ; k < member_count ; k++ ) {
+            reduced_member_type& e = reduced_members_[k];
+            contact_type& c = *e.representative;
+            point_type* p = e.point;
+
+            p->new_position += c.displacement;
+            p->tmp_velocity = p->new_position - p->old_position;
+        }
+
 #if 0
 		// Ή`FbN
 		std::map< int, std::vector< int > > m;
@@ -1580,6 +2933,14 @@ private:
 		dprintf_real( "\n" );
 #endif
 
+        // ̃t[pɊoĂ
+        if( contact_cache_enabled_ ) {
+            for( typename contacts_type::iterator i = contacts_.begin() ;
+                 i != contacts_.end() ;
+                 ++i ) {
+                contact_cache_.store( **i );
+            }
+        }
     }
 
     void update_frozen( real_type dt, real_type idt )
@@ -1601,6 +2962,20 @@ private:
             p->get_actual_contact_list().clear();
         }
 
+        for( typename plane_constraints_type::iterator i =
+                 plane_constraints_.begin() ;
+             i != plane_constraints_.end() ;
+             ++i ) {
+            plane_constraint_type& c = *i;
+
+            c.A_body->get_actual_contact_list().push_back( c.plane );
+            c.plane->get_actual_contact_list().push_back( c.A_body );
+            if( c.A_body->get_alive() &&
+                !c.A_body->get_frozen() ) {
+                c.plane->set_defrosting( true );
+            }
+        }                
+
         for( typename constraints_type::iterator i =
                  constraints_.begin() ;
              i != constraints_.end() ;
@@ -1660,6 +3035,238 @@ private:
             p->update_boundingbox();
             p->end_frame();
         }
+
+        broad_S_.clear();
+        scratch_.reset();
+    }
+
+    //// island sleeping
+
+    // Ă悢body
+    //   planeȂǂstaticȂ̂islandɂ͊܂߂Ȃ
+    static bool is_static_body( body_type* b )
+    {
+        return b->classid() == BODY_ID_PLANE;
+    }
+    static bool is_calm_body( body_type* b )
+    {
+        return b->get_frozen() && !b->get_defrosting();
+    }
+
+    template < class PTraits >
+    class island_collector {
+    public:
+        island_collector( World< PTraits >* w, body_type* x )
+            : w_( w ), x_( x ) {}
+        
+        void operator()( Collidable< PTraits >* y ) const
+        {
+            if( !x_->test_collision_filter( y->get_body() ) ) { return; }
+            w_->unite_island( x_, y->get_body() );
+        }
+
+    private:
+        World< PTraits >*   w_;
+        body_type*          x_;
+
+    };
+    template < class T > friend class island_collector;
+
+    int find_island( int i )
+    {
+        std::vector< int >& parent = island_parent_;
+        while( parent[i] != i ) {
+            parent[i] = parent[parent[i]];
+            i = parent[i];
+        }
+        return i;
+    }
+
+    void unite_island( body_type* x, body_type* y )
+    {
+        if( x == y || is_static_body( y ) ) { return; }
+
+        int xi = find_island( x->get_slot() );
+        if( !is_calm_body( y ) ) {
+            // Ă̂ƐڂĂ
+            island_tainted_[xi] = 1;
+            return;
+        }
+
+        int yi = find_island( y->get_slot() );
+        if( xi == yi ) { return; }
+        island_parent_[yi] = xi;
+        island_tainted_[xi] |= island_tainted_[yi];
+    }
+
+    void fall_asleep()
+    {
+        int n = int( bodies_.size() );
+
+        bool found = false;
+        for( int i = 0 ; i < n ; i++ ) {
+            body_type* b = bodies_[i];
+            if( !is_static_body( b ) && is_calm_body( b ) ) {
+                found = true;
+                break;
+            }
+        }
+        if( !found ) { return; }
+
+        // calmbodymAABB̏dȂłȂA
+        // calmłȂbodyƏdȂĂ̂܂island͏O
+        island_parent_.resize( n );
+        island_tainted_.resize( n );
+        island_index_.resize( n );
+        for( int i = 0 ; i < n ; i++ ) {
+            island_parent_[i] = i;
+            island_tainted_[i] = 0;
+            island_index_[i] = -1;
+        }
+
+        vector_type margin;
+        margin.x = margin.y = margin.z = SLEEPING_ISLAND_MARGIN;
+
+        collidables_type& S = sleep_S_;
+        for( int i = 0 ; i < n ; i++ ) {
+            body_type* b = bodies_[i];
+            if( is_static_body( b ) || !is_calm_body( b ) ) { continue; }
+
+            S.clear();
+            b->list_collision_units( S );
+            for( typename collidables_type::const_iterator j = S.begin() ;
+                 j != S.end() ;
+                 ++j ) {
+                aabbt_.detect(
+                    (*j)->get_bbmin() - margin,
+                    (*j)->get_bbmax() + margin,
+                    island_collector< Traits >( this, b ) );
+                static_aabbt_.detect(
+                    (*j)->get_bbmin() - margin,
+                    (*j)->get_bbmax() + margin,
+                    island_collector< Traits >( this, b ) );
+            }
+        }
+
+        // islandɂ܂Ƃ߂
+        int first_island = int( islands_.size() );
+        for( int i = 0 ; i < n ; i++ ) {
+            body_type* b = bodies_[i];
+            if( is_static_body( b ) || !is_calm_body( b ) ) { continue; }
+
+            int root = find_island( i );
+            if( island_tainted_[root] ) { continue; }
+
+            if( island_index_[root] < 0 ) {
+                island_type island;
+                island.bbmin = math< Traits >::vector_max();
+                island.bbmax = math< Traits >::vector_min();
+                island_index_[root] = int( islands_.size() );
+                islands_.push_back( island );
+            }
+
+            island_type& island = islands_[island_index_[root]];
+            island.bodies.push_back( b );
+
+            S.clear();
+            b->list_collision_units( S );
+            for( typename collidables_type::const_iterator j = S.begin() ;
+                 j != S.end() ;
+                 ++j ) {
+                math< Traits >::update_bb(
+                    island.bbmin, island.bbmax, (*j)->get_bbmin() );
+                math< Traits >::update_bb(
+                    island.bbmin, island.bbmax, (*j)->get_bbmax() );
+            }
+        }
+
+        // bodies_O
+        int m = int( islands_.size() );
+        for( int k = first_island ; k < m ; k++ ) {
+            island_type& island = islands_[k];
+            for( typename bodies_type::const_iterator j =
+                     island.bodies.begin() ;
+                 j != island.bodies.end() ;
+                 ++j ) {
+                body_type* b = *j;
+                remove_body_slot( b );
+                b->set_island( k );
+            }
+        }
+    }
+
+    void wake_touched_islands()
+    {
+        if( islands_.empty() ) { return; }
+
+        collidables_type& S = sleep_S_;
+
+        // Nbody͖ɒǉ邪A
+        // calmȂ̂ŌȂĂ悢
+        int n = int( bodies_.size() );
+        for( int i = 0 ; i < n && !islands_.empty() ; i++ ) {
+            body_type* b = bodies_[i];
+            if( is_static_body( b ) || is_calm_body( b ) ) { continue; }
+
+            S.clear();
+            b->list_collision_units( S );
+            for( typename collidables_type::const_iterator j = S.begin() ;
+                 j != S.end() ;
+                 ++j ) {
+                collidable_type* c = *j;
+                for( int k = int( islands_.size() ) - 1 ; 0 <= k ; k-- ) {
+                    island_type& island = islands_[k];
+                    if( math< Traits >::test_aabb_aabb(
+                            c->get_bbmin(), c->get_bbmax(),
+                            island.bbmin, island.bbmax ) ) {
+                        wake_island( k );
+                    }
+                }
+            }
+        }
+    }
+
+    void wake_island( int k )
+    {
+        // treeɂislandɂĂȂbodył̂
+        query_tree_dirty_ = true;
+
+        island_type& island = islands_[k];
+        for( typename bodies_type::const_iterator i =
+                 island.bodies.begin() ;
+             i != island.bodies.end() ;
+             ++i ) {
+            body_type* b = *i;
+            b->set_island( -1 );
+            b->set_slot( int( bodies_.size() ) );
+            bodies_.push_back( b );
+        }
+
+        // island󂢂ƂɈڂ
+        if( k != int( islands_.size() ) - 1 ) {
+            std::swap( island, islands_.back() );
+            for( typename bodies_type::const_iterator i =
+                     island.bodies.begin() ;
+                 i != island.bodies.end() ;
+                 ++i ) {
+                (*i)->set_island( k );
+            }
+        }
+        islands_.pop_back();
+    }
+
+    void wake_body_internal( body_type* p )
+    {
+        if( 0 <= p->get_island() ) {
+            wake_island( p->get_island() );
+        }
+    }
+
+    void wake_all_internal()
+    {
+        while( !islands_.empty() ) {
+            wake_island( int( islands_.size() ) - 1 );
+        }
     }
 
     void debug_check()
@@ -1702,36 +3309,10 @@ private:
         block_type* x = static_cast< block_type* >( xx );
         plane_type* y = static_cast< plane_type* >( yy );
 
-        if( !math< Traits >::test_aabb_plane( x->get_bbmin(),
-                                              x->get_bbmax(),
-                                              y->get_position(),
-                                              y->get_normal() ) ) {
-            return;
-        }
-
         // TODO: cloudLĂƂɕsƂɂȂIII
-        cloud_type* cloud = x->get_cloud();
-                        
-        // foreach cloud.point
-        for( points_iterator j = cloud->get_points().begin() ;
-             j != cloud->get_points().end() ;
-             ++j ) {
-            point_type& point = *j;
-            const vector_type& np = point.new_position;
-
-            real_type pdotn = dot( np - y->position_, y->normal_ );
-
-            if( 0 < pdotn ) { continue; }
-                                
-            Constraint< Traits > c;
-            c.A_body        = x->get_body();
-            c.B_body        = y;
-            c.point         = &point;
-            c.plane_normal  = y->normal_;
-            c.plane_position = y->position_;
-                        
-            constraints_.push_back( c );
-        }
+        add_plane_constraints(
+            x->get_body(), y, x->get_bbmin(), x->get_bbmax(),
+            x->get_cloud()->get_points() );
     }
 
     void collision_resolver_shell_cloth(
@@ -1764,36 +3345,61 @@ private:
         softvolume_type* x = static_cast< softvolume_type* >( xx );
         plane_type* y = static_cast< plane_type* >( yy );
 
-        if( !math< Traits >::test_aabb_plane( x->get_bbmin(),
-                                              x->get_bbmax(),
-                                              y->get_position(),
-                                              y->get_normal() ) ) {
+        add_plane_constraints(
+            x->get_body(), y, x->get_bbmin(), x->get_bbmax(),
+            x->get_mesh()->get_points() );
+    }
+
+    void add_plane_constraints(
+        body_type*          body,
+        plane_type*         y,
+        const vector_type&  bbmin,
+        const vector_type&  bbmax,
+        points_type&        points )
+    {
+        const vector_type& n = y->get_normal();
+
+        // AABBʂ̕\Ɏ܂Ă(̒body̑唼)Ȃ
+        //   swept collision̂Ƃ͋߂ÂĂ̂E悤]T
+        vector_type position = y->get_position();
+        if( swept_collision_ ) { position += n * SWEPT_COLLISION_MARGIN; }
+        if( !math< Traits >::test_aabb_halfspace(
+                bbmin, bbmax, position, n ) ) {
             return;
         }
 
-        typedef typename softvolume_type::points_type points_type;
-
-        points_type& points = x->get_mesh()->get_points();
-                
-        // foreach cloud.point
-        for( typename points_type::iterator j = points.begin() ;
-             j !=points.end() ;
-             ++j ) {
-            point_type& p = *j;
-
-            real_type pdotn = dot(
-                p.new_position - y->position_, y->normal_ );
-            if( 0 < pdotn ) { continue; }
-                                
-            Constraint< Traits > c;
-            c.A_body         = x->get_body();
-            c.B_body         = y;
-            c.point          = &p;
-            c.plane_normal   = y->normal_;
-            c.plane_position = y->position_;
+        // dot( p - position, n ) <= 0  dot( p, n ) <= d Ŕ肷
+        real_type d = dot( y->get_position(), n );
 
-            constraints_.push_back( c );
+        int begin = int( plane_points_.size() );
+        int m = int( points.size() );
+        if( swept_collision_ ) {
+            // ̃Xebv̗\ʒuʂ̗ɂ_܂߂
+            for( int j = 0 ; j < m ; j++ ) {
+                point_type& p = points[j];
+                real_type vn = dot( p.new_position - p.old_position, n );
+                real_type pd = dot( p.new_position, n );
+                if( vn < 0 ) { pd += vn; }
+                if( d < pd ) { continue; }
+                plane_points_.push_back( &p );
+            }
+        } else {
+            for( int j = 0 ; j < m ; j++ ) {
+                point_type& p = points[j];
+                if( d < dot( p.new_position, n ) ) { continue; }
+                plane_points_.push_back( &p );
+            }
         }
+
+        int end = int( plane_points_.size() );
+        if( begin == end ) { return; }
+
+        plane_constraint_type c;
+        c.A_body = body;
+        c.plane  = y;
+        c.begin  = begin;
+        c.end    = end;
+        plane_constraints_.push_back( c );
     }
 
     void collision_resolver_volume_cloth(
@@ -1944,12 +3550,28 @@ private:
             b_body->get_alive() && b_body->get_influential() ) {
 
 			if( rs->uvt.z < rs->target->penetration_magnifier ) {
+				// swept rayłȂrs->end == target->new_position
+				vector_type vv = ( rs->end - rs->source );
+				vector_type v = vv * ( real_type( 1.0 ) - rs->uvt.z );
+				real_type depth =
+					dot( -v, plane_normal ) +
+					dot( rs->end - rs->target->new_position, plane_normal );
+
+				if( depth <= 0 ) {
+					// ܂ʂɓ͂ĂȂ(speculative)
+					constraint_type c;
+					c.A_body          = a_body;
+					c.B_body          = b_body;
+					c.point           = rs->target;
+					c.plane_normal    = plane_normal;
+					c.plane_position  = rs->end - v;
+					constraints_.push_back( c );
+					return;
+				}
+
 				rs->target->penetration_magnifier = rs->uvt.z;
 
-				vector_type vv = ( rs->target->new_position - rs->source );
-				vector_type v = vv * ( real_type( 1.0 ) - rs->uvt.z );
-				vector_type penetration =
-					plane_normal * dot( -v, plane_normal );
+				vector_type penetration = plane_normal * depth;
 
 				contact_type* c = (contact_type*)contact_pool_.allocate();
 				c->A_body = a_body;
@@ -1963,7 +3585,7 @@ private:
 				c->v = rs->uvt.y;
 				c->w = real_type( 1.0 ) - c->u - c->v;
 				c->t = rs->uvt.z;
-				c->alpha = 0;
+				warm_start_contact( c );
 				c->check();
 
 				contacts_.push_back( c );
@@ -1980,7 +3602,22 @@ private:
     }
 
 
+    // Ot[ɓ(A_point, Op`)contactagep
+    //   alphaapply_contactsŌvZ
+    void warm_start_contact( contact_type* c )
+    {
+        c->mass = c->A_point->mass;
+        c->alpha = 0;
+        c->age = 0;
+        if( !contact_cache_enabled_ ) { return; }
+
+        const contact_cache_entry_type* e = contact_cache_.find(
+            c->A_point, c->B_point0, c->B_point1, c->B_point2 );
+        if( e ) { c->age = e->age + 1; }
+    }
+
     // penetration_face_spatial_hash_replierĂ΂wp[֐
+    //   B_normal͎Op`̖ʖ@(LbV)BNULLȂvZ
     void add_contact(
         body_type* A_body,
         body_type* B_body,
@@ -1991,7 +3628,8 @@ private:
         real_type u,
         real_type v,
         real_type w,
-		real_type t )
+		real_type t,
+        const vector_type* B_normal = NULL )
     {
         if( !A_body->get_positive() && !B_body->get_positive() ) { 
             // UIuWFNgȂ牽Ȃ
@@ -2008,6 +3646,11 @@ private:
             return;
         }
 
+        if( !A_body->test_collision_filter( B_body ) ) {
+            // narrow phasȇgɂ邾̑ContactCachê
+            return;
+        }
+
         if( A_body->get_alive() && A_body->get_influential() &&
             B_body->get_alive() && A_body->get_influential() ) {
 
@@ -2025,7 +3668,7 @@ private:
 				c->v = v;
 				c->w = w;
 				c->t = t;
-				c->alpha = 0;
+				warm_start_contact( c );
 				c->check();
 
 				contacts_.push_back( c );
@@ -2034,9 +3677,14 @@ private:
             const vector_type& v0 = B_point0->new_position;
             const vector_type& v1 = B_point1->new_position;
             const vector_type& v2 = B_point2->new_position;
-                        
-            vector_type plane_normal = cross( v1 - v0, v2 - v0 );
-            math< Traits >::normalize_f( plane_normal );
+
+            vector_type plane_normal;
+            if( B_normal ) {
+                plane_normal = *B_normal;
+            } else {
+                plane_normal = cross( v1 - v0, v2 - v0 );
+                math< Traits >::normalize_f( plane_normal );
+            }
 
             constraint_type c;
             c.A_body        = A_body;
@@ -2071,6 +3719,11 @@ private:
             return;
         }
 
+        if( !A_body->test_collision_filter( B_body ) ) {
+            // narrow phasȇgɂ邾̑ContactCachê
+            return;
+        }
+
         constraint_type c;
         c.A_body          = A_body;
         c.B_body          = B_body;
@@ -2087,18 +3740,67 @@ private:
     int                                    body_id_seed_;
     real_type                              time_;
 	real_type							   previous_idt_;
+    real_type                              fixed_timestep_;
+    int                                    max_substeps_;
+    real_type                              accumulator_;
+    real_type                              interpolation_alpha_;
+    real_type                              dropped_time_;
+    bool                                   adaptive_timestep_;
+    real_type                              min_timestep_;
+    real_type                              max_timestep_;
+    real_type                              current_timestep_;
+    real_type                              max_penetration_;
+    real_type                              max_distortion_;
+    int                                    calm_steps_;
+    int                                    rollback_count_;
+    int                                    shape_iterations_;
+    real_type                              shape_tolerance_;
+    int                                    shape_iteration_count_;
+    Snapshot< Traits >                     rollback_;
     bodies_type                            bodies_;
     std::vector< collision_resolver_type > collision_resolver_table_;
     constraints_type                       constraints_;
+    plane_constraints_type                 plane_constraints_;
+    plane_points_type                      plane_points_;
+    contact_incidences_type                contact_incidences_;
+    int                                    contact_reduction_cap_;
+    int                                    contact_count_before_reduction_;
+    bool                                   swept_collision_;
+    bool                                   query_tree_dirty_;
+    int                                    query_island_count_;
+    collidables_type                       query_island_units_;
+    std::vector< int >                     query_island_begin_;
+    contacts_type                          reduction_sorted_;
+    std::vector< real_type >               reduction_distance_;
+    std::vector< int >                     reduction_nearest_;
+    reduced_members_type                   reduced_members_;
+    std::vector< int >                     passive_points_;
+    contact_incidences_type                active_incidences_;
+    std::vector< int >                     active_points_;
     contacts_type                          contacts_;
-	default_page_provider					page_provider_;
-	fixed_pool< sizeof( contact_type ), default_page_provider > contact_pool_;
+	page_arena								arena_; // Worldpoolׂ͂Ă
+	arena_page_provider						page_provider_;
+	fixed_pool< sizeof( contact_type ), arena_page_provider > contact_pool_;
+    contact_cache_type                     contact_cache_;
+    int                                    contact_cache_hit_count_;
+    bool                                   contact_cache_enabled_;
+    scratch_allocator_type                 scratch_;
+    collidables_type                       broad_S_;
+    collidables_type                       broad_T_;
+    collidables_type                       broad_D_;
+    islands_type                           islands_;
+    collidables_type                       sleep_S_;
+    std::vector< int >                     island_parent_;
+    std::vector< char >                    island_tainted_;
+    std::vector< int >                     island_index_;
+    size_t                                 step_allocation_count_;
     //BroadSpatialHash< Traits >      broad_spatial_hash_;
-    aabb_tree_type                         aabbt_;
+    aabb_tree_type                         aabbt_;           // Ă(t[쐬)
+    aabb_tree_type                         static_aabbt_;    // planeƎ~܂Ă
+    static_entries_type                    static_entries_;
     ray_processor_type                     ray_processor_;
     PointTetrahedronSpatialHash< Traits >  point_tetrahedron_spatial_hash_;
-    EdgeFaceSpatialHash< Traits >          edge_face_spatial_hash_;
-    PenetrationFaceSpatialHash< Traits >   penetration_face_spatial_hash_;
+    VolumeFaceSpatialHash< Traits >        volume_face_spatial_hash_;
     ClothPointTetrahedronSpatialHash< Traits > cloth_point_tetrahedron_spatial_hash_;
     ClothSpikeFaceSpatialHash< Traits >        cloth_spike_face_spatial_hash_;
     ClothEdgeFaceSpatialHash< Traits >      cloth_edge_face_spatial_hash_;
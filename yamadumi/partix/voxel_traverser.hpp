@@ -148,4 +148,180 @@ private:
 		
 };
 
+// N{segment܂Ƃ߂ĒH
+//	 [Ƃ̌vZvoxel_traverserƓȂ̂œZ𓯂ɕԂB
+//	 Ԃ[Ƃ̔zŎAselectɂĂ̂
+//	 step_packet̓RpCSIMDł
+template < class Real, class Vector, int N >
+class voxel_packet_traverser {
+public:
+	typedef Real	real_type;
+	typedef Vector	vector_type;
+
+public:
+	voxel_packet_traverser(
+		const vector_type* v0,
+		const vector_type* v1,
+		int n,
+		real_type gridsize )
+		: n_( n ),
+		  gridsize_( gridsize ),
+		  rgridsize_( real_type( 1.0 ) / gridsize )
+	{
+		for( int i = 0 ; i < N ; i++ ) {
+			ok_[i] = false;
+			x_[i] = y_[i] = z_[i] = 0;
+			endx_[i] = endy_[i] = endz_[i] = 0;
+			stepx_[i] = stepy_[i] = stepz_[i] = 0;
+			tmaxx_[i] = tmaxy_[i] = tmaxz_[i] = 0;
+			tdeltax_[i] = tdeltay_[i] = tdeltaz_[i] = 0;
+		}
+		for( int i = 0 ; i < n ; i++ ) {
+			init_lane( i, v0[i], v1[i] );
+		}
+	}
+	~voxel_packet_traverser(){}
+
+	// ܂IĂȂ[̐
+	int active_count() const
+	{
+		int m = 0;
+		for( int i = 0 ; i < N ; i++ ) { m += ok_[i] ? 1 : 0; }
+		return m;
+	}
+
+	// S[1Zi߂Bvalid[i]falsẽ[͏IĂ
+	void step_packet( int* x, int* y, int* z, bool* valid )
+	{
+		for( int i = 0 ; i < N ; i++ ) {
+			valid[i] = ok_[i];
+			x[i] = x_[i];
+			y[i] = y_[i];
+			z[i] = z_[i];
+
+			bool done =
+				endx_[i] * stepx_[i] <= x_[i] * stepx_[i] &&
+				endy_[i] * stepy_[i] <= y_[i] * stepy_[i] &&
+				endz_[i] * stepz_[i] <= z_[i] * stepz_[i];
+			ok_[i] = ok_[i] && !done;
+
+			bool ax = tmaxx_[i] < tmaxy_[i] && tmaxx_[i] < tmaxz_[i];
+			bool ay = !ax && tmaxy_[i] < tmaxz_[i];
+			bool az = !ax && !ay;
+			x_[i] += ax ? stepx_[i] : 0;
+			y_[i] += ay ? stepy_[i] : 0;
+			z_[i] += az ? stepz_[i] : 0;
+			tmaxx_[i] = ax ? tmaxx_[i] + tdeltax_[i] : tmaxx_[i];
+			tmaxy_[i] = ay ? tmaxy_[i] + tdeltay_[i] : tmaxy_[i];
+			tmaxz_[i] = az ? tmaxz_[i] + tdeltaz_[i] : tmaxz_[i];
+		}
+	}
+
+	// [i1Zi߂([΂炯ĂƂp)
+	bool step_lane( int i, int& x, int& y, int& z )
+	{
+		if( !ok_[i] ) { return false; }
+
+		x = x_[i];
+		y = y_[i];
+		z = z_[i];
+		if( endx_[i] * stepx_[i] <= x_[i] * stepx_[i] &&
+			endy_[i] * stepy_[i] <= y_[i] * stepy_[i] &&
+			endz_[i] * stepz_[i] <= z_[i] * stepz_[i] ) {
+			ok_[i] = false;
+		}
+
+		if( tmaxx_[i] < tmaxy_[i] ) {
+			if( tmaxx_[i] < tmaxz_[i] ) {
+				x_[i] += stepx_[i]; tmaxx_[i] += tdeltax_[i];
+			} else {
+				z_[i] += stepz_[i]; tmaxz_[i] += tdeltaz_[i];
+			}
+		} else {
+			if( tmaxy_[i] < tmaxz_[i] ) {
+				y_[i] += stepy_[i]; tmaxy_[i] += tdeltay_[i];
+			} else {
+				z_[i] += stepz_[i]; tmaxz_[i] += tdeltaz_[i];
+			}
+		}
+		return true;
+	}
+
+private:
+	void init_lane( int i, const vector_type& v0, const vector_type& v1 )
+	{
+		vector_type v = v1 - v0;
+
+		x_[i] = coord( v0.x );
+		y_[i] = coord( v0.y );
+		z_[i] = coord( v0.z );
+
+		endx_[i] = coord( v1.x );
+		endy_[i] = coord( v1.y );
+		endz_[i] = coord( v1.z );
+
+		stepx_[i] = sgn( v.x );
+		stepy_[i] = sgn( v.y );
+		stepz_[i] = sgn( v.z );
+
+		set_tmax( tmaxx_[i], v.x, v0.x, stepx_[i] );
+		set_tmax( tmaxy_[i], v.y, v0.y, stepy_[i] );
+		set_tmax( tmaxz_[i], v.z, v0.z, stepz_[i] );
+
+		tdeltax_[i] = std::abs( gridsize_ / v.x );
+		tdeltay_[i] = std::abs( gridsize_ / v.y );
+		tdeltaz_[i] = std::abs( gridsize_ / v.z );
+		if( x_[i] == endx_[i] ) {
+			tdeltax_[i] = 0;
+			tmaxx_[i] = (std::numeric_limits< real_type >::max)();
+		}
+		if( y_[i] == endy_[i] ) {
+			tdeltay_[i] = 0;
+			tmaxy_[i] = (std::numeric_limits< real_type >::max)();
+		}
+		if( z_[i] == endz_[i] ) {
+			tdeltaz_[i] = 0;
+			tmaxz_[i] = (std::numeric_limits< real_type >::max)();
+		}
+
+		ok_[i] = true;
+	}
+
+	int coord( real_type a ) { return int( floor( a * rgridsize_ ) ); }
+
+	int sgn( real_type x )
+	{
+		if( x < 0 ) { return -1; }
+		else if( 0 < x ) { return 1; }
+		else { return 0; }
+	}
+
+	real_type nearest_bound( int step, real_type a )
+	{
+		if( step < 0 ) {
+			return floor( a * rgridsize_ ) * gridsize_;
+		} else {
+			return ceil( a * rgridsize_ ) * gridsize_;
+		}
+	}
+	void set_tmax( real_type& tmax, real_type v, real_type v0, int step )
+	{
+		if( v == 0 ) {
+			tmax = (std::numeric_limits< real_type >::max)();
+		} else {
+			tmax = std::abs( ( nearest_bound( step, v0 ) - v0 ) / v );
+		}
+	}
+
+	int n_;
+	real_type gridsize_, rgridsize_;
+	int x_[N], y_[N], z_[N];
+	int endx_[N], endy_[N], endz_[N];
+	int stepx_[N], stepy_[N], stepz_[N];
+	real_type tmaxx_[N], tmaxy_[N], tmaxz_[N];
+	real_type tdeltax_[N], tdeltay_[N], tdeltaz_[N];
+	bool ok_[N];
+
+};
+
 #endif // VOXEL_TRAVERSER_HPP
@@ -10,6 +10,8 @@
 
 const float MIKU_MASS = 0.5f;
 const float MIKU_SCALE = 0.02f;
+const int ENTITY_CAPACITY = 64;         // この数までは登録で再割り当てしない
+const size_t ENTITY_BLOCK_SIZE = 64;    // body_ptrの制御ブロックの大きさの上限
 
 /*===========================================================================*/
 /*!
@@ -97,6 +99,9 @@ typedef partix::SoftShell<PartixTraits>         softshell_type;
 typedef partix::SoftVolume<PartixTraits>        softvolume_type;
 typedef partix::BoundingPlane<PartixTraits>     plane_type;
 typedef partix::TetrahedralMesh<PartixTraits>   tetra_type;
+typedef partix::Prefab<PartixTraits>            prefab_type;
+typedef partix::PrefabRegistry<PartixTraits>    prefab_registry_type;
+typedef partix::DistanceLodSelector<PartixTraits> lod_selector_type;
 typedef partix::Face<PartixTraits>              face_type;
 
 typedef std::shared_ptr<body_type>              body_ptr;
@@ -104,9 +109,57 @@ typedef std::shared_ptr<cloud_type>             cloud_ptr;
 typedef std::shared_ptr<block_type>             block_ptr;
 typedef std::shared_ptr<softvolume_type>        softvolume_ptr;
 
+typedef fixed_pool<ENTITY_BLOCK_SIZE, default_page_provider> entity_pool_type;
+
+/*===========================================================================*/
+/*!
+ * entity_allocator
+ *
+ *  entityのbody_ptrの制御ブロック用アロケータ
+ *  PartixWorldのentity_pool_type(固定サイズ)から取って返すので、
+ *  spawn/despawnを繰り返してもヒープ割り当ては起きない
+ */
+/*==========================================================================*/
+
+template <class T>
+class entity_allocator {
+public:
+    typedef T value_type;
+
+    explicit entity_allocator(entity_pool_type* pool) : pool_(pool) {}
+    template <class U>
+    entity_allocator(const entity_allocator<U>& x) : pool_(x.pool_) {}
+
+    T* allocate(size_t n) {
+        static_assert(sizeof(T) <= ENTITY_BLOCK_SIZE,
+                      "ENTITY_BLOCK_SIZE is too small");
+        assert(n == 1);
+        return static_cast<T*>(pool_->allocate());
+    }
+    void deallocate(T* p, size_t) {
+        pool_->deallocate(p);
+    }
+
+    template <class U>
+    bool operator==(const entity_allocator<U>& x) const {
+        return pool_ == x.pool_;
+    }
+    template <class U>
+    bool operator!=(const entity_allocator<U>& x) const {
+        return pool_ != x.pool_;
+    }
+
+private:
+    entity_pool_type* pool_;
+
+    template <class U> friend class entity_allocator;
+};
+
 class PartixWorld {
 public:
-    PartixWorld() {
+    PartixWorld()
+        : entity_pool_(entity_page_provider_, "entity"),
+          lod_selector_(vector_type(0, 0, 0), 13.0f, 16.0f) {
         stretch_factor_ = 0.7;
         restore_factor_ = 1.0;
         friction_ = 0.3;
@@ -118,13 +171,27 @@ public:
         world_->restart();
     }
 
-    void update() {
-        world_->update(PartixTraits::tick());
+    // elapsed: 前回からの実時間(秒)
+    void update(float elapsed) {
+        world_->advance(elapsed);
+    }
+
+    // 視点から遠いものは粗いメッシュで計算する
+    void update_lod(const vector_type& view_point) {
+        lod_selector_.set_view_point(view_point);
+        prefabs_.find("miku2_p")->update_lod(lod_selector_, world_.get());
+    }
+
+    float get_interpolation_alpha() {
+        return world_->get_interpolation_alpha();
     }
 
     void build() {
         // ...world
         world_.reset(new world_type);
+        bodies_.reserve(6 + ENTITY_CAPACITY);
+        models_.reserve(ENTITY_CAPACITY);
+        world_->set_fixed_timestep(PartixTraits::tick(), 4);
 
         // ...room
         for (int i = 0 ; i <6 ; i++) {
@@ -145,6 +212,14 @@ public:
             bodies_.push_back(e);
             world_->add_body(e.get());
         }
+
+        // ...prefab
+        if (!prefabs_.find("miku2_p")) {
+            prefab_type* prefab =
+                prefabs_.add("miku2_p", make_volume_mesh(MIKU_SCALE*100));
+            prefab->set_coarse_template(
+                partix::make_lattice_mesh(prefab->get_template(), 1));
+        }
     }
 
     body_ptr add_entity() {
@@ -154,8 +229,9 @@ public:
         o.y = float(rand() % 6001 - 3000) / 2000;
         o.z = float(rand() % 6001 - 3000) / 2000;
 
-        // 作成
-        softvolume_type* v = make_volume_body(MIKU_SCALE*100);
+        // 作成(プールから再利用)
+        prefab_type* prefab = prefabs_.find("miku2_p");
+        softvolume_type* v = prefab->spawn();
 
         // 硬さ、摩擦
         v->set_stretch_factor(stretch_factor_);
@@ -165,7 +241,13 @@ public:
         }
                                 
         // 登録
-        body_ptr e(v);
+        //  解放時はdeleteせずにプールへ返す(制御ブロックもプールから取る)
+        body_ptr e(
+            v,
+            [prefab](body_type* b) {
+                prefab->despawn(static_cast<softvolume_type*>(b));
+            },
+            entity_allocator<body_type>(&entity_pool_));
         e->teleport(o);
         e->set_auto_freezing(false);
         bodies_.push_back(e);
@@ -177,8 +259,15 @@ public:
         return e;
     }
 
+    void remove_entity(body_ptr e) {
+        world_->remove_body(e.get());
+        swap_remove(bodies_, e);
+        swap_remove(models_, e);
+    }
+
     void set_gravity(const vector_type& v) {
         for (auto body: models_) {
+            world_->wake_body(body.get());
             body->set_frozen(false);
             body->set_global_force(v);
         }
@@ -214,7 +303,15 @@ public:
     }
 
 private:
-    softvolume_type* make_volume_body(float mag) {
+    // 順序は問わないので末尾と入れ替えて消す
+    static void swap_remove(std::vector<body_ptr>& v, const body_ptr& e) {
+        auto i = std::find(v.begin(), v.end(), e);
+        assert(i != v.end());
+        std::swap(*i, v.back());
+        v.pop_back();
+    }
+
+    tetra_type* make_volume_mesh(float mag) {
         vector_type v0(0, 0, 0);
 
         tetra_type* e = new tetra_type;
@@ -263,21 +360,18 @@ private:
 
         printf("D\n");
         e->setup();
-        softvolume_type* v = new softvolume_type;
-
-        printf("E\n");
-        v->set_mesh(e);
 
-        printf("F\n");
-        v->regularize();
-
-        return v;
+        return e;
     }
 
 private:
+    default_page_provider       entity_page_provider_;
+    entity_pool_type            entity_pool_;   // bodies_より先に破棄しないこと
+    prefab_registry_type        prefabs_;   // bodies_より先に破棄しないこと
     std::unique_ptr<world_type> world_;
     std::vector<body_ptr>       bodies_;    // 全部
     std::vector<body_ptr>       models_;    // figure系だけ
+    lod_selector_type           lod_selector_;
 
     float stretch_factor_;
     float restore_factor_;
@@ -22,11 +22,13 @@ public:
 
     }
 
-    void update() {
-        world_->update();
+    void update(float elapsed) {
+        world_->update(elapsed);
+        world_->update_lod(screen_.make_view_point());
 
+        float alpha = world_->get_interpolation_alpha();
         for (const auto& bind: binds_) {
-            update_entity(bind.first, bind.second);
+            update_entity(bind.first, bind.second, alpha);
         }
         
         Vector view_point = screen_.make_view_point();
@@ -41,9 +43,9 @@ public:
         }
     }
 
-    void update_entity(body_ptr body, figure_ptr figure) {
+    void update_entity(body_ptr body, figure_ptr figure, float alpha) {
         softvolume_ptr v = std::dynamic_pointer_cast<softvolume_type>(body);
-        Matrix m = v->get_deformed_matrix();
+        Matrix m = v->get_interpolated_deformed_matrix(alpha);
         figure->set_transform(m);
     }
 
@@ -122,8 +124,8 @@ void start(int argc, const char *argv[]) {
     bindings->add_body(screen);
 
     screen.on_idle(
-        [=](float){
-            bindings->update();
+        [=](float elapsed){
+            bindings->update(elapsed);
         });
 
     screen.do_main_loop();